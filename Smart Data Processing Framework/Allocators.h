@@ -0,0 +1,278 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Bump allocator over blocks it keeps for reuse. Deallocation is a no-op;
+// memory comes back all at once through rewind() or reset(), after which
+// the same blocks are handed out again, so a workload that repeats
+// reaches a steady state with no heap traffic at all.
+class MonotonicArena {
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+    // Position to rewind() to; everything allocated after it is released
+    struct Marker {
+        size_t block = 0;
+        size_t offset = 0;
+    };
+
+    explicit MonotonicArena(size_t blockSize = kDefaultBlockSize) : blockSize_(blockSize) {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        for (; current_ < blocks_.size(); ++current_, offset_ = 0) {
+            if (void* memory = carve(bytes, alignment)) {
+                return memory;
+            }
+        }
+        // Every kept block is used up: add one
+        size_t size = std::max(blockSize_, bytes + alignment);
+        blocks_.push_back({std::unique_ptr<unsigned char[]>(new unsigned char[size]), size});
+        current_ = blocks_.size() - 1;
+        offset_ = 0;
+        return carve(bytes, alignment);
+    }
+
+    Marker mark() const {
+        return {current_, offset_};
+    }
+
+    void rewind(Marker marker) {
+        current_ = marker.block;
+        offset_ = marker.offset;
+    }
+
+    // Release everything, keeping the blocks
+    void reset() {
+        rewind({});
+    }
+
+    size_t reservedBytes() const {
+        size_t total = 0;
+        for (const auto& block : blocks_) total += block.size;
+        return total;
+    }
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> data;
+        size_t size;
+    };
+
+    // Take bytes from the current block, or return nullptr if they do not fit
+    void* carve(size_t bytes, size_t alignment) {
+        Block& block = blocks_[current_];
+        auto base = reinterpret_cast<uintptr_t>(block.data.get());
+        uintptr_t aligned = (base + offset_ + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        size_t end = static_cast<size_t>(aligned - base) + bytes;
+        if (end > block.size) {
+            return nullptr;
+        }
+        offset_ = end;
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    size_t blockSize_;
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+    size_t offset_ = 0;
+};
+
+// Standard allocator drawing from a MonotonicArena, for containers whose
+// storage only has to live until the arena is rewound
+template<typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(MonotonicArena& arena) : arena_(&arena) {}
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena_(other.arena()) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T*, size_t) {}
+
+    MonotonicArena* arena() const {
+        return arena_;
+    }
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena_ == other.arena();
+    }
+
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return arena_ != other.arena();
+    }
+
+private:
+    MonotonicArena* arena_;
+};
+
+template<typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// The calling thread's arena for temporaries. Every worker, and every
+// producer thread, gets its own, so it needs no locking.
+inline MonotonicArena& scratchArena() {
+    thread_local MonotonicArena arena;
+    return arena;
+}
+
+// Rewinds the arena to where it was when the scope opened. Scopes nest,
+// so a call that opens one may run inside another on the same thread;
+// containers using the scope must be declared after it.
+class ScratchScope {
+public:
+    explicit ScratchScope(MonotonicArena& arena = scratchArena())
+        : arena_(arena), marker_(arena.mark()) {}
+
+    ~ScratchScope() {
+        arena_.rewind(marker_);
+    }
+
+    ScratchScope(const ScratchScope&) = delete;
+    ScratchScope& operator=(const ScratchScope&) = delete;
+
+    template<typename T>
+    ArenaAllocator<T> allocator() const {
+        return ArenaAllocator<T>(arena_);
+    }
+
+private:
+    MonotonicArena& arena_;
+    MonotonicArena::Marker marker_;
+};
+
+// FIFO storage in one slab of uninitialized slots, used as a circular
+// buffer. The slab doubles when full and is never given back, so once a
+// queue has reached its working depth, pushes and pops allocate nothing.
+template<typename T>
+class SlabRing {
+public:
+    explicit SlabRing(size_t initialSlots = 0) {
+        if (initialSlots > 0) {
+            grow(roundUpToPowerOfTwo(initialSlots));
+        }
+    }
+
+    ~SlabRing() {
+        clear();
+    }
+
+    SlabRing(const SlabRing&) = delete;
+    SlabRing& operator=(const SlabRing&) = delete;
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (size_ == capacity_) {
+            grow(capacity_ ? capacity_ * 2 : kMinSlots);
+        }
+        T* item = ::new (static_cast<void*>(slot((head_ + size_) & mask_))) T(std::forward<Args>(args)...);
+        ++size_;
+        return *item;
+    }
+
+    void push_back(const T& item) {
+        emplace_back(item);
+    }
+
+    void push_back(T&& item) {
+        emplace_back(std::move(item));
+    }
+
+    T& front() {
+        return *slot(head_);
+    }
+
+    const T& front() const {
+        return *slot(head_);
+    }
+
+    // index-th item from the front
+    const T& operator[](size_t index) const {
+        return *slot((head_ + index) & mask_);
+    }
+
+    void pop_front() {
+        slot(head_)->~T();
+        head_ = (head_ + 1) & mask_;
+        --size_;
+    }
+
+    void clear() {
+        while (size_ > 0) {
+            pop_front();
+        }
+        head_ = 0;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    // Slots allocated so far
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    static constexpr size_t kMinSlots = 16;
+
+    struct alignas(T) Slot {
+        unsigned char bytes[sizeof(T)];
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t capacity = 1;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    T* slot(size_t index) const {
+        return std::launder(reinterpret_cast<T*>(slots_[index].bytes));
+    }
+
+    // Move the items, oldest first, to the front of a larger slab. The
+    // slab is zeroed, so its pages are first touched (and, on a NUMA
+    // machine, placed) by the thread that grows the ring: the one that
+    // constructs it for the initial slab, and whichever thread pushed
+    // into the full ring for every later one.
+    void grow(size_t count) {
+        std::unique_ptr<Slot[]> fresh(new Slot[count]());
+        for (size_t i = 0; i < size_; ++i) {
+            T* item = slot((head_ + i) & mask_);
+            ::new (static_cast<void*>(fresh[i].bytes)) T(std::move(*item));
+            item->~T();
+        }
+        slots_ = std::move(fresh);
+        capacity_ = count;
+        mask_ = count - 1;
+        head_ = 0;
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t capacity_ = 0;
+    size_t mask_ = 0;
+    size_t head_ = 0;
+    size_t size_ = 0;
+};
@@ -0,0 +1,583 @@
+#pragma once
+
+// Coroutine-based processors for I/O-bound stages. Needs C++20
+// coroutines (configure with -DSDPF_ENABLE_COROUTINES=ON); on older
+// standards this header declares nothing and SDPF_HAS_COROUTINES is 0.
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#define SDPF_HAS_COROUTINES 1
+#else
+#define SDPF_HAS_COROUTINES 0
+#endif
+
+#if SDPF_HAS_COROUTINES
+
+#include <coroutine>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <exception>
+#include <queue>
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+
+#include "Processor.h"
+#include "Allocators.h"
+#include "Logger.h"
+
+// ============ TASK ============
+
+// Lazily started coroutine producing a T. Awaiting it runs it to
+// completion and resumes the awaiter, without going through the loop.
+template<typename T = void>
+class Task;
+
+namespace detail {
+
+// Hands control straight to whoever awaited the finished task
+struct FinalTransfer {
+    bool await_ready() noexcept { return false; }
+
+    template<typename Promise>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept {
+        return self.promise().continuation;
+    }
+
+    void await_resume() noexcept {}
+};
+
+struct TaskPromiseBase {
+    std::coroutine_handle<> continuation = std::noop_coroutine();
+    std::exception_ptr error;
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    FinalTransfer final_suspend() noexcept { return {}; }
+
+    void unhandled_exception() {
+        error = std::current_exception();
+    }
+};
+
+} // namespace detail
+
+template<typename T>
+class Task {
+public:
+    struct promise_type : detail::TaskPromiseBase {
+        std::optional<T> value;
+
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        template<typename U>
+        void return_value(U&& result) {
+            value.emplace(std::forward<U>(result));
+        }
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept {
+        return !handle_ || handle_.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+
+    T await_resume() {
+        auto& promise = handle_.promise();
+        if (promise.error) std::rethrow_exception(promise.error);
+        return std::move(*promise.value);
+    }
+
+    std::coroutine_handle<promise_type> handle() const {
+        return handle_;
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+template<>
+class Task<void> {
+public:
+    struct promise_type : detail::TaskPromiseBase {
+        Task get_return_object() {
+            return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        void return_void() {}
+    };
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (handle_) handle_.destroy();
+            handle_ = std::exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Task() {
+        if (handle_) handle_.destroy();
+    }
+
+    bool await_ready() const noexcept {
+        return !handle_ || handle_.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle_.promise().continuation = awaiter;
+        return handle_;
+    }
+
+    void await_resume() {
+        if (handle_.promise().error) std::rethrow_exception(handle_.promise().error);
+    }
+
+    std::coroutine_handle<promise_type> handle() const {
+        return handle_;
+    }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+// ============ EVENT LOOP ============
+
+// Runs coroutines on the calling thread: those that are ready, in the
+// order they became ready, and those whose timer has expired. Other
+// threads hand a coroutine back with post(), e.g. from an I/O callback.
+class EventLoop {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    EventLoop() = default;
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    // The loop running on this thread, or nullptr outside runUntil()
+    static EventLoop* current() {
+        return currentSlot();
+    }
+
+    // Queue a coroutine to run on the loop. Safe from any thread.
+    void post(std::coroutine_handle<> handle) {
+        // Notify under the lock: once it is released the loop may finish
+        // and be destroyed
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(handle);
+        wake_.notify_one();
+    }
+
+    // Resume handle at deadline. Loop thread only.
+    void addTimer(Clock::time_point deadline, std::coroutine_handle<> handle) {
+        timers_.push(Timer{deadline, nextTimer_++, handle});
+    }
+
+    // Start task; it runs until its first suspension
+    void start(Task<void>& task) {
+        CurrentScope scope(this);
+        task.handle().resume();
+    }
+
+    // Run coroutines until done() holds. Blocks while nothing is ready.
+    template<typename Predicate>
+    void runUntil(Predicate done) {
+        CurrentScope scope(this);
+        std::vector<std::coroutine_handle<>> running;
+        while (!done()) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (ready_.empty()) {
+                    if (timers_.empty()) {
+                        wake_.wait(lock, [this] { return !ready_.empty(); });
+                    } else {
+                        wake_.wait_until(lock, timers_.top().deadline,
+                                         [this] { return !ready_.empty(); });
+                    }
+                }
+                running.swap(ready_);
+            }
+            Clock::time_point now = Clock::now();
+            while (!timers_.empty() && timers_.top().deadline <= now) {
+                running.push_back(timers_.top().handle);
+                timers_.pop();
+            }
+            for (auto handle : running) {
+                handle.resume();
+            }
+            running.clear();
+        }
+    }
+
+private:
+    struct Timer {
+        Clock::time_point deadline;
+        uint64_t order;
+        std::coroutine_handle<> handle;
+
+        // Earliest deadline on top; ties keep the order they were added in
+        bool operator<(const Timer& other) const {
+            return deadline != other.deadline ? deadline > other.deadline : order > other.order;
+        }
+    };
+
+    static EventLoop*& currentSlot() {
+        thread_local EventLoop* loop = nullptr;
+        return loop;
+    }
+
+    // Nested loops restore the outer one on exit
+    struct CurrentScope {
+        explicit CurrentScope(EventLoop* loop) : previous(currentSlot()) { currentSlot() = loop; }
+        ~CurrentScope() { currentSlot() = previous; }
+        EventLoop* previous;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::coroutine_handle<>> ready_;
+    std::priority_queue<Timer> timers_;
+    uint64_t nextTimer_ = 0;
+};
+
+// co_await sleepFor(5ms): suspend for a while without blocking the thread
+inline auto sleepFor(EventLoop::Clock::duration delay) {
+    struct Sleep {
+        EventLoop::Clock::duration delay;
+        bool await_ready() const noexcept { return delay <= EventLoop::Clock::duration::zero(); }
+        void await_suspend(std::coroutine_handle<> handle) const {
+            EventLoop::current()->addTimer(EventLoop::Clock::now() + delay, handle);
+        }
+        void await_resume() const noexcept {}
+    };
+    return Sleep{delay};
+}
+
+// co_await yieldNow(): let the other ready coroutines run first
+inline auto yieldNow() {
+    struct Yield {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) const {
+            EventLoop::current()->post(handle);
+        }
+        void await_resume() const noexcept {}
+    };
+    return Yield{};
+}
+
+// Bridges a callback-style API into a coroutine: pass a copy to the
+// callback, which calls set() or fail() from any thread, and co_await
+// the Completion in the coroutine. Each Completion is awaited once.
+template<typename T>
+class Completion {
+public:
+    Completion() : state_(std::make_shared<State>()) {}
+
+    void set(T value) {
+        finish([&](State& state) { state.value.emplace(std::move(value)); });
+    }
+
+    void fail(std::exception_ptr error) {
+        finish([&](State& state) { state.error = std::move(error); });
+    }
+
+    bool await_ready() const {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        return state_->finished;
+    }
+
+    // Returns false, resuming at once, when set() won the race
+    bool await_suspend(std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->finished) return false;
+        state_->waiter = handle;
+        state_->loop = EventLoop::current();
+        return true;
+    }
+
+    T await_resume() {
+        if (state_->error) std::rethrow_exception(state_->error);
+        return std::move(*state_->value);
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        bool finished = false;
+        std::optional<T> value;
+        std::exception_ptr error;
+        std::coroutine_handle<> waiter;
+        EventLoop* loop = nullptr;
+    };
+
+    template<typename Store>
+    void finish(Store store) {
+        std::coroutine_handle<> waiter;
+        EventLoop* loop = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->finished) return;
+            store(*state_);
+            state_->finished = true;
+            waiter = state_->waiter;
+            loop = state_->loop;
+        }
+        if (waiter) loop->post(waiter);
+    }
+
+    std::shared_ptr<State> state_;
+};
+
+// ============ ASYNC PROCESSOR ============
+
+// Processor whose work is a coroutine, for stages that mostly wait
+// (lookups, remote calls). processAsync() should await the I/O through
+// Completion, sleepFor() and the like; a blocking call inside it still
+// blocks the whole worker thread. Return nullopt to drop the item.
+template<typename T>
+class AsyncProcessor {
+public:
+    virtual ~AsyncProcessor() = default;
+
+    virtual Task<std::optional<T>> processAsync(const T& input) = 0;
+
+    virtual std::string getName() const = 0;
+
+    // Whether processAsync() can ever return nullopt
+    virtual bool dropsItems() const {
+        return false;
+    }
+
+    // Coroutines of one batch always share a thread, but several workers
+    // run batches at once, as for Processor::isStateless()
+    virtual bool isStateless() const {
+        return false;
+    }
+
+    virtual void reset() {}
+};
+
+// Runs an AsyncProcessor as an ordinary Processor. Each batch a worker
+// hands over runs on an event loop on that worker's thread, with up to
+// maxInFlight items in progress at once, so a worker keeps a whole batch
+// waiting on I/O instead of one item. Give workers batches at least
+// maxInFlight long (ProcessingSystem::setAsyncProcessor() does).
+//
+// If any item throws, the rest of the batch still completes, then the
+// first exception is rethrown. As for any batch kernel that throws, the
+// worker goes over the batch again item by item; those calls replay the
+// outcomes already recorded, so nothing runs twice and exactly the items
+// that failed are counted as errors. Outcomes are found by the item's
+// address, so this only holds when the retry passes the batch's own
+// items: fused with other stages into a CompositeProcessor (or one
+// Pipeline segment), the stage is retried on copies and every item's
+// I/O runs again.
+template<typename T>
+class AsyncStage : public Processor<T> {
+public:
+    static constexpr size_t kDefaultMaxInFlight = 1024;
+
+    explicit AsyncStage(std::shared_ptr<AsyncProcessor<T>> processor,
+                        size_t maxInFlight = kDefaultMaxInFlight)
+        : processor_(std::move(processor)), maxInFlight_(std::max<size_t>(maxInFlight, 1)) {}
+
+    T process(const T& input) override {
+        std::optional<T> result = tryProcess(input);
+        return result ? std::move(*result) : T();
+    }
+
+    std::optional<T> tryProcess(const T& input) override {
+        Replay& replay = replayed();
+        if (replay.covers(this, &input)) {
+            return replay.take(&input);
+        }
+        ScratchScope scratch;
+        ArenaVector<std::optional<T>> results(1, std::nullopt, scratch.allocator<std::optional<T>>());
+        runBatch(&input, results.data(), 1);
+        return std::move(results[0]);
+    }
+
+    void processBatch(const T* in, T* out, size_t n) override {
+        ScratchScope scratch;
+        ArenaVector<std::optional<T>> results(n, std::nullopt, scratch.allocator<std::optional<T>>());
+        runBatch(in, results.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = results[i] ? std::move(*results[i]) : T();
+        }
+    }
+
+    bool dropsItems() const override {
+        return processor_->dropsItems();
+    }
+
+    size_t processBatchFiltered(const T* in, T* out, uint8_t* keep, size_t n) override {
+        ScratchScope scratch;
+        ArenaVector<std::optional<T>> results(n, std::nullopt, scratch.allocator<std::optional<T>>());
+        runBatch(in, results.data(), n);
+        size_t kept = 0;
+        for (size_t i = 0; i < n; ++i) {
+            keep[i] = results[i] ? 1 : 0;
+            if (results[i]) {
+                out[kept++] = std::move(*results[i]);
+            }
+        }
+        return kept;
+    }
+
+    std::string getName() const override {
+        return "Async(" + processor_->getName() + ")";
+    }
+
+    bool isStateless() const override {
+        return processor_->isStateless();
+    }
+
+    bool needsInputOrder() const override {
+        return !processor_->isStateless();
+    }
+
+    // Retried items replay their recorded outcomes
+    bool canRetryBatch() const override {
+        return true;
+    }
+
+    void reset() override {
+        processor_->reset();
+        Processor<T>::reset();
+    }
+
+    size_t maxInFlight() const {
+        return maxInFlight_;
+    }
+
+private:
+    struct Batch {
+        const T* in = nullptr;
+        std::optional<T>* results = nullptr;
+        std::exception_ptr* errors = nullptr;
+        size_t n = 0;
+        size_t next = 0;
+        size_t liveLanes = 0;
+        bool failed = false;
+    };
+
+    // Outcomes of this thread's last failed batch, handed out once each
+    // to the worker's item-by-item pass over the same items
+    struct Replay {
+        const AsyncStage* owner = nullptr;
+        const T* begin = nullptr;
+        size_t remaining = 0;
+        std::vector<std::optional<T>> results;
+        std::vector<std::exception_ptr> errors;
+
+        bool covers(const AsyncStage* stage, const T* item) const {
+            std::less<const T*> before;
+            return owner == stage && !before(item, begin) && before(item, begin + results.size());
+        }
+
+        std::optional<T> take(const T* item) {
+            size_t i = static_cast<size_t>(item - begin);
+            std::optional<T> result = std::move(results[i]);
+            std::exception_ptr error = errors[i];
+            if (--remaining == 0) {
+                owner = nullptr;
+                results.clear();
+                errors.clear();
+            }
+            if (error) std::rethrow_exception(error);
+            return result;
+        }
+    };
+
+    static Replay& replayed() {
+        thread_local Replay replay;
+        return replay;
+    }
+
+    // One lane keeps one item in flight, taking the next when it finishes
+    Task<void> lane(Batch& batch) {
+        for (size_t i = batch.next++; i < batch.n; i = batch.next++) {
+            try {
+                batch.results[i] = co_await processor_->processAsync(batch.in[i]);
+            } catch (...) {
+                batch.errors[i] = std::current_exception();
+                batch.failed = true;
+            }
+        }
+        --batch.liveLanes;
+    }
+
+    void runBatch(const T* in, std::optional<T>* results, size_t n) {
+        if (n == 0) return;
+        Replay& replay = replayed();
+        if (replay.owner == this) {
+            replay.owner = nullptr; // A new batch: the old one was not replayed
+        }
+
+        ScratchScope scratch;
+        ArenaVector<std::exception_ptr> errors(n, nullptr, scratch.allocator<std::exception_ptr>());
+        Batch batch;
+        batch.in = in;
+        batch.results = results;
+        batch.errors = errors.data();
+        batch.n = n;
+
+        EventLoop loop;
+        size_t count = std::min(n, maxInFlight_);
+        ArenaVector<Task<void>> lanes(scratch.allocator<Task<void>>());
+        lanes.reserve(count);
+        batch.liveLanes = count;
+        for (size_t i = 0; i < count; ++i) {
+            lanes.push_back(lane(batch));
+            loop.start(lanes.back());
+        }
+        loop.runUntil([&batch] { return batch.liveLanes == 0; });
+
+        if (batch.failed) {
+            replay.owner = this;
+            replay.begin = in;
+            replay.remaining = n;
+            replay.results.assign(std::make_move_iterator(results), std::make_move_iterator(results + n));
+            replay.errors.assign(errors.begin(), errors.end());
+            std::exception_ptr first = *std::find_if(errors.begin(), errors.end(),
+                                                     [](const std::exception_ptr& e) { return e != nullptr; });
+            std::rethrow_exception(first);
+        }
+    }
+
+    std::shared_ptr<AsyncProcessor<T>> processor_;
+    size_t maxInFlight_;
+};
+
+#endif // SDPF_HAS_COROUTINES
@@ -0,0 +1,589 @@
+// Benchmark suite for the processing framework.
+//
+// Sweeps worker count, queue capacity, batch size, queue backend,
+// scheduling mode, payload type and processor type. Every configuration
+// is warmed up, then measured several times; each run reports throughput,
+// enqueue-to-result latency percentiles and heap allocations per item
+// (counted by the global operator new below). Results can be written as
+// JSON or CSV for tracking across commits.
+//
+//   SmartDataProcessingBenchmark --workers 1,4,8 --batch 1,64 --json out.json
+//   SmartDataProcessingBenchmark --full --label $(git rev-parse --short HEAD)
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <array>
+#include <map>
+#include <set>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+#include <new>
+#include <optional>
+
+#include "ProcessingSystem.h"
+#include "ProcessorFactory.h"
+#include "Pipeline.h"
+#include "StaticProcessingSystem.h"
+
+using BenchClock = std::chrono::steady_clock;
+
+// ============ ALLOCATION COUNTING ============
+
+// Every allocation in the process, so a run can report how many it paid
+// per item once the system is warmed up
+std::atomic<uint64_t> gAllocations{0};
+
+// Kept out of line: once inlined, GCC pairs the free() with the caller's
+// new expression and warns about a mismatch (-Wmismatched-new-delete)
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+BENCH_NOINLINE void* operator new(std::size_t size) {
+    gAllocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+BENCH_NOINLINE void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+BENCH_NOINLINE void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// ============ PAYLOADS ============
+
+// Heavy record payload: 256 bytes copied by value
+struct LargeRecord {
+    std::array<double, 32> fields{};
+};
+
+// Wraps each payload with its enqueue timestamp so the collector can
+// measure enqueue-to-result latency
+template<typename T>
+struct Timed {
+    T value{};
+    BenchClock::time_point enqueuedAt{};
+};
+
+// Runs an inner processor on the payload of Timed<T>, keeping the inner
+// processor's batch kernel, in-place path and drop path
+template<typename T>
+class TimedProcessor : public Processor<Timed<T>> {
+public:
+    explicit TimedProcessor(std::shared_ptr<Processor<T>> inner) : inner_(std::move(inner)) {}
+
+    Timed<T> process(const Timed<T>& input) override {
+        return {inner_->process(input.value), input.enqueuedAt};
+    }
+
+    void processBatch(const Timed<T>* in, Timed<T>* out, size_t n) override {
+        thread_local std::vector<T> values;
+        thread_local std::vector<T> results;
+        values.resize(n);
+        results.resize(n);
+        for (size_t i = 0; i < n; ++i) values[i] = in[i].value;
+        inner_->processBatch(values.data(), results.data(), n);
+        for (size_t i = 0; i < n; ++i) {
+            out[i].value = std::move(results[i]);
+            out[i].enqueuedAt = in[i].enqueuedAt;
+        }
+    }
+
+    void processInPlace(Timed<T>& value) override {
+        inner_->processInPlace(value.value);
+    }
+
+    bool processesInPlace() const override {
+        return inner_->processesInPlace();
+    }
+
+    bool dropsItems() const override {
+        return inner_->dropsItems();
+    }
+
+    std::optional<Timed<T>> tryProcess(const Timed<T>& input) override {
+        std::optional<T> result = inner_->tryProcess(input.value);
+        if (!result) return std::nullopt;
+        return Timed<T>{std::move(*result), input.enqueuedAt};
+    }
+
+    size_t processBatchFiltered(const Timed<T>* in, Timed<T>* out, uint8_t* keep,
+                                size_t n) override {
+        thread_local std::vector<T> values;
+        thread_local std::vector<T> results;
+        values.resize(n);
+        results.resize(n);
+        for (size_t i = 0; i < n; ++i) values[i] = in[i].value;
+        size_t kept = inner_->processBatchFiltered(values.data(), results.data(), keep, n);
+        // The k-th result belongs to the k-th kept item
+        size_t next = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (!keep[i]) continue;
+            out[next].enqueuedAt = in[i].enqueuedAt;
+            out[next].value = std::move(results[next]);
+            ++next;
+        }
+        return kept;
+    }
+
+    bool isStateless() const override {
+        return inner_->isStateless();
+    }
+
+    bool canRetryBatch() const override {
+        return inner_->canRetryBatch();
+    }
+
+    bool isPure() const override {
+        return inner_->isPure();
+    }
+
+    std::string getName() const override {
+        return inner_->getName();
+    }
+
+private:
+    std::shared_ptr<Processor<T>> inner_;
+};
+
+// Scales every field of a LargeRecord
+class RecordScaleProcessor : public Processor<LargeRecord> {
+public:
+    LargeRecord process(const LargeRecord& input) override {
+        LargeRecord result = input;
+        processInPlace(result);
+        return result;
+    }
+
+    void processInPlace(LargeRecord& value) override {
+        for (auto& field : value.fields) field *= 1.5;
+    }
+
+    bool processesInPlace() const override {
+        return true;
+    }
+
+    bool isStateless() const override {
+        return true;
+    }
+
+    std::string getName() const override {
+        return "RecordScaleProcessor";
+    }
+};
+
+template<typename T> T makePayload(size_t i);
+template<> int makePayload<int>(size_t i) { return static_cast<int>(i % 1000) - 500; }
+template<> double makePayload<double>(size_t i) { return static_cast<double>(i % 1000) - 500.0; }
+template<> std::string makePayload<std::string>(size_t i) { return "payload-" + std::to_string(i % 1000); }
+template<> LargeRecord makePayload<LargeRecord>(size_t i) {
+    LargeRecord record;
+    record.fields.fill(static_cast<double>(i % 1000));
+    return record;
+}
+
+// ============ CONFIGURATION ============
+
+struct BenchConfig {
+    std::string payload;
+    std::string processor;
+    std::string queue;
+    std::string scheduler;
+    size_t workers;
+    size_t capacity;
+    size_t batch;
+};
+
+struct RunResult {
+    double itemsPerSec;
+    double p50Us;
+    double p99Us;
+    double p999Us;
+    double allocsPerItem;
+    size_t items;
+};
+
+struct BenchOptions {
+    std::vector<size_t> workers = {1, 4};
+    std::vector<size_t> capacities = {4096};
+    std::vector<size_t> batches = {1, 64};
+    std::vector<std::string> queues = {"data", "ring"};
+    std::vector<std::string> schedulers = {"shared"};
+    std::set<std::string> payloads = {"int", "double", "string", "large"};
+    std::set<std::string> processors = {"numeric", "amplification", "filtering", "record",
+                                        "chain", "static-chain"};
+    size_t items = 100000;
+    size_t warmup = 10000;
+    size_t repetitions = 3;
+    std::string jsonPath;
+    std::string csvPath;
+    std::string label;
+};
+
+// ============ MEASUREMENT ============
+
+double percentile(const std::vector<int64_t>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t index = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size()))) - 1;
+    return static_cast<double>(sorted[std::min(index, sorted.size() - 1)]) / 1000.0;
+}
+
+// Push `count` items through the system and, if latencies is non-null,
+// record each item's enqueue-to-result latency in nanoseconds. Returns
+// how many items came out or were dropped by the processor.
+template<typename T, template<typename> class QueueT>
+size_t pump(ProcessingSystem<Timed<T>, QueueT>& system, size_t count, size_t batch,
+            std::vector<int64_t>* latencies) {
+    size_t filteredBefore = system.getStatistics().totalFiltered;
+    auto filtered = [&system, filteredBefore] {
+        return system.getStatistics().totalFiltered - filteredBefore;
+    };
+
+    std::thread producer([&system, count, batch] {
+        std::vector<Timed<T>> chunk;
+        for (size_t sent = 0; sent < count;) {
+            size_t n = std::min(batch, count - sent);
+            if (n == 1) {
+                system.addData(Timed<T>{makePayload<T>(sent), BenchClock::now()}, 5000);
+            } else {
+                chunk.clear();
+                auto now = BenchClock::now();
+                for (size_t i = 0; i < n; ++i) {
+                    chunk.push_back(Timed<T>{makePayload<T>(sent + i), now});
+                }
+                system.addBatch(std::move(chunk), 5000);
+            }
+            sent += n;
+        }
+    });
+
+    size_t collected = 0;
+    int idleRounds = 0;
+    std::vector<Timed<T>> results;
+    while (collected + filtered() < count && idleRounds < 10) {
+        results.clear();
+        if (system.pollResults(results, std::max<size_t>(batch, 256), 100) == 0) {
+            ++idleRounds;
+            continue;
+        }
+        idleRounds = 0;
+        if (latencies) {
+            auto now = BenchClock::now();
+            for (const auto& result : results) {
+                latencies->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - result.enqueuedAt).count());
+            }
+        }
+        collected += results.size();
+    }
+
+    producer.join();
+    return collected + filtered();
+}
+
+template<typename T, template<typename> class QueueT>
+RunResult runOnce(const BenchConfig& config, std::shared_ptr<Processor<T>> processor,
+                  const BenchOptions& options) {
+    ProcessingSystem<Timed<T>, QueueT> system(config.workers, config.capacity);
+    system.setWorkerBatchSize(config.batch);
+    if (config.scheduler == "stealing") {
+        system.setSchedulingMode(SchedulingMode::WORK_STEALING);
+    }
+    system.setProcessor(std::make_shared<TimedProcessor<T>>(processor));
+    system.start();
+
+    pump<T>(system, options.warmup, config.batch, nullptr);
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(options.items);
+    uint64_t allocationsBefore = gAllocations.load(std::memory_order_relaxed);
+    auto start = BenchClock::now();
+    size_t handled = pump<T>(system, options.items, config.batch, &latencies);
+    auto elapsed = std::chrono::duration<double>(BenchClock::now() - start).count();
+    uint64_t allocations = gAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+    system.stop();
+
+    std::sort(latencies.begin(), latencies.end());
+    return {
+        elapsed > 0 ? static_cast<double>(handled) / elapsed : 0.0,
+        percentile(latencies, 0.50),
+        percentile(latencies, 0.99),
+        percentile(latencies, 0.999),
+        handled ? static_cast<double>(allocations) / static_cast<double>(handled) : 0.0,
+        handled
+    };
+}
+
+template<typename T>
+RunResult runWithQueue(const BenchConfig& config, std::shared_ptr<Processor<T>> processor,
+                       const BenchOptions& options) {
+    if (config.queue == "ring") {
+        return runOnce<T, RingBufferQueue>(config, processor, options);
+    }
+    return runOnce<T, DataQueue>(config, processor, options);
+}
+
+// Processor instances for a payload type; empty when the combination
+// does not apply
+template<typename T>
+std::shared_ptr<Processor<T>> makeProcessor(const std::string& name) {
+    auto& factory = ProcessorFactory<T>::getInstance();
+    if (name == "numeric") return factory.createProcessor(NumericConfig{3.0});
+    if (name == "amplification") return factory.createProcessor(AmplificationConfig{1.5});
+    if (name == "filtering") return factory.createProcessor(FilteringConfig{0.0});
+    // The same three stages, chained at run time and at compile time
+    if (name == "chain") {
+        return std::make_shared<CompositeProcessor<T>>(std::vector<std::shared_ptr<Processor<T>>>{
+            makeProcessor<T>("numeric"), makeProcessor<T>("amplification"),
+            makeProcessor<T>("filtering")});
+    }
+    if (name == "static-chain") {
+        return std::make_shared<StaticChain<T, Multiply<T, Constant<3>>, Amplify<T, Constant<3, 2>>,
+                                            Threshold<T, Constant<0>>>>();
+    }
+    return nullptr;
+}
+
+template<>
+std::shared_ptr<Processor<std::string>> makeProcessor<std::string>(const std::string& name) {
+    if (name == "numeric") {
+        NumericConfig config;
+        config.repetitions = 2;
+        return ProcessorFactory<std::string>::getInstance().createProcessor(config);
+    }
+    return nullptr;
+}
+
+template<>
+std::shared_ptr<Processor<LargeRecord>> makeProcessor<LargeRecord>(const std::string& name) {
+    if (name == "record") return std::make_shared<RecordScaleProcessor>();
+    return nullptr;
+}
+
+// ============ REPORTING ============
+
+struct Row {
+    BenchConfig config;
+    size_t repetition;
+    RunResult result;
+};
+
+std::string toJson(const std::vector<Row>& rows, const std::string& label) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"label\": \"" << label << "\",\n  \"simd\": \""
+        << simd::levelName(simd::activeLevel()) << "\",\n  \"results\": [\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const auto& r = rows[i];
+        out << "    {\"payload\": \"" << r.config.payload
+            << "\", \"processor\": \"" << r.config.processor
+            << "\", \"queue\": \"" << r.config.queue
+            << "\", \"scheduler\": \"" << r.config.scheduler
+            << "\", \"workers\": " << r.config.workers
+            << ", \"capacity\": " << r.config.capacity
+            << ", \"batch\": " << r.config.batch
+            << ", \"repetition\": " << r.repetition
+            << ", \"items\": " << r.result.items
+            << ", \"items_per_sec\": " << r.result.itemsPerSec
+            << ", \"p50_us\": " << r.result.p50Us
+            << ", \"p99_us\": " << r.result.p99Us
+            << ", \"p999_us\": " << r.result.p999Us
+            << ", \"allocs_per_item\": " << r.result.allocsPerItem << "}"
+            << (i + 1 < rows.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+std::string toCsv(const std::vector<Row>& rows, const std::string& label) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "label,payload,processor,queue,scheduler,workers,capacity,batch,repetition,"
+           "items,items_per_sec,p50_us,p99_us,p999_us,allocs_per_item\n";
+    for (const auto& r : rows) {
+        out << label << "," << r.config.payload << "," << r.config.processor << ","
+            << r.config.queue << "," << r.config.scheduler << "," << r.config.workers << ","
+            << r.config.capacity << "," << r.config.batch << "," << r.repetition << ","
+            << r.result.items << "," << r.result.itemsPerSec << "," << r.result.p50Us << ","
+            << r.result.p99Us << "," << r.result.p999Us << "," << r.result.allocsPerItem << "\n";
+    }
+    return out.str();
+}
+
+void printRow(const Row& r) {
+    std::cout << std::left << std::setw(8) << r.config.payload
+              << std::setw(15) << r.config.processor
+              << std::setw(6) << r.config.queue
+              << std::setw(10) << r.config.scheduler
+              << std::right << std::setw(4) << r.config.workers
+              << std::setw(8) << r.config.capacity
+              << std::setw(6) << r.config.batch
+              << std::setw(4) << r.repetition
+              << std::fixed << std::setprecision(0)
+              << std::setw(14) << r.result.itemsPerSec
+              << std::setprecision(1)
+              << std::setw(11) << r.result.p50Us
+              << std::setw(11) << r.result.p99Us
+              << std::setw(11) << r.result.p999Us
+              << std::setprecision(2)
+              << std::setw(9) << r.result.allocsPerItem << std::endl;
+}
+
+// ============ DRIVER ============
+
+template<typename T>
+void sweepPayload(const std::string& payload, const BenchOptions& options, std::vector<Row>& rows) {
+    if (!options.payloads.count(payload)) return;
+
+    for (const auto& processorName : options.processors) {
+        auto processor = makeProcessor<T>(processorName);
+        if (!processor) continue;
+
+        for (const auto& queue : options.queues)
+        for (const auto& scheduler : options.schedulers)
+        for (size_t workers : options.workers)
+        for (size_t capacity : options.capacities)
+        for (size_t batch : options.batches) {
+            BenchConfig config{payload, processorName, queue, scheduler, workers, capacity, batch};
+            for (size_t rep = 0; rep < options.repetitions; ++rep) {
+                rows.push_back({config, rep, runWithQueue<T>(config, processor, options)});
+                printRow(rows.back());
+            }
+        }
+    }
+}
+
+template<typename V>
+std::vector<V> parseList(const std::string& text, std::function<V(const std::string&)> convert) {
+    std::vector<V> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(convert(item));
+    }
+    return values;
+}
+
+void printUsage() {
+    std::cout <<
+        "Usage: SmartDataProcessingBenchmark [options]\n"
+        "  --workers LIST     worker counts (default 1,4)\n"
+        "  --capacity LIST    queue capacities (default 4096)\n"
+        "  --batch LIST       producer/worker batch sizes (default 1,64)\n"
+        "  --queue LIST       data,ring (default both)\n"
+        "  --scheduler LIST   shared,stealing (default shared)\n"
+        "  --payload LIST     int,double,string,large (default all)\n"
+        "  --processor LIST   numeric,amplification,filtering,record,chain,\n"
+        "                     static-chain (default all)\n"
+        "  --items N          measured items per run (default 100000)\n"
+        "  --warmup N         warmup items per run (default 10000)\n"
+        "  --reps N           measured runs per configuration (default 3)\n"
+        "  --full             sweep workers 1,2,4,8, capacity 1024,16384,\n"
+        "                     batch 1,32,256 and both schedulers\n"
+        "  --json FILE        write results as JSON\n"
+        "  --csv FILE         write results as CSV\n"
+        "  --label TEXT       tag stored with the results (e.g. commit id)\n";
+}
+
+int main(int argc, char** argv) {
+    Logger::getInstance().setLogLevel(Logger::Level::WARNING);
+
+    BenchOptions options;
+    auto toSize = [](const std::string& s) { return static_cast<size_t>(std::stoull(s)); };
+    auto toString = [](const std::string& s) { return s; };
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                std::exit(EXIT_FAILURE);
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--workers") options.workers = parseList<size_t>(next(), toSize);
+        else if (arg == "--capacity") options.capacities = parseList<size_t>(next(), toSize);
+        else if (arg == "--batch") options.batches = parseList<size_t>(next(), toSize);
+        else if (arg == "--queue") options.queues = parseList<std::string>(next(), toString);
+        else if (arg == "--scheduler") options.schedulers = parseList<std::string>(next(), toString);
+        else if (arg == "--payload") {
+            auto list = parseList<std::string>(next(), toString);
+            options.payloads = std::set<std::string>(list.begin(), list.end());
+        }
+        else if (arg == "--processor") {
+            auto list = parseList<std::string>(next(), toString);
+            options.processors = std::set<std::string>(list.begin(), list.end());
+        }
+        else if (arg == "--items") options.items = toSize(next());
+        else if (arg == "--warmup") options.warmup = toSize(next());
+        else if (arg == "--reps") options.repetitions = toSize(next());
+        else if (arg == "--json") options.jsonPath = next();
+        else if (arg == "--csv") options.csvPath = next();
+        else if (arg == "--label") options.label = next();
+        else if (arg == "--full") {
+            options.workers = {1, 2, 4, 8};
+            options.capacities = {1024, 16384};
+            options.batches = {1, 32, 256};
+            options.schedulers = {"shared", "stealing"};
+        }
+        else if (arg == "--help" || arg == "-h") {
+            printUsage();
+            return EXIT_SUCCESS;
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::cout << "SIMD level: " << simd::levelName(simd::activeLevel())
+              << ", hardware threads: " << std::thread::hardware_concurrency() << "\n\n";
+    std::cout << std::left << std::setw(8) << "payload" << std::setw(15) << "processor"
+              << std::setw(6) << "queue" << std::setw(10) << "sched"
+              << std::right << std::setw(4) << "wrk" << std::setw(8) << "cap"
+              << std::setw(6) << "batch" << std::setw(4) << "rep"
+              << std::setw(14) << "items/sec" << std::setw(11) << "p50 us"
+              << std::setw(11) << "p99 us" << std::setw(11) << "p999 us"
+              << std::setw(9) << "alloc/it" << std::endl;
+
+    std::vector<Row> rows;
+    try {
+        sweepPayload<int>("int", options, rows);
+        sweepPayload<double>("double", options, rows);
+        sweepPayload<std::string>("string", options, rows);
+        sweepPayload<LargeRecord>("large", options, rows);
+    } catch (const std::exception& e) {
+        std::cerr << "Benchmark failed: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!options.jsonPath.empty()) {
+        std::ofstream(options.jsonPath) << toJson(rows, options.label);
+        std::cout << "\nJSON written to " << options.jsonPath << std::endl;
+    }
+    if (!options.csvPath.empty()) {
+        std::ofstream(options.csvPath) << toCsv(rows, options.label);
+        std::cout << "CSV written to " << options.csvPath << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+// Spacing that keeps independently written data off each other's cache
+// lines. GCC's std::hardware_destructive_interference_size depends on
+// -mtune and warns when used in headers (-Winterference-size), so GCC and
+// Clang use the common x86/ARM line size instead.
+#if defined(__cpp_lib_hardware_interference_size) && !defined(__GNUC__)
+inline constexpr std::size_t kCacheLineSize = std::hardware_destructive_interference_size;
+#else
+inline constexpr std::size_t kCacheLineSize = 64;
+#endif
+
+// Hint to the CPU that we are busy-waiting
+inline void cpuRelax() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
@@ -0,0 +1,533 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "Processor.h"
+#include "Allocators.h"
+#include "CacheLine.h"
+#include "ShardedCounter.h"
+#include "Logger.h"
+
+// Fixed-size memo of processor results: input -> output, or "dropped".
+// Sets of kWays entries, evicted by CLOCK: a hit only sets the entry's
+// reference bit, and an insert into a full set takes the first entry
+// whose bit is clear, clearing bits as it passes. Memory is bounded by
+// the capacity given at construction and allocated once.
+//
+// Values of at most 8 bytes that are trivially copyable (int, float,
+// double, ...) live in atomics guarded by a per-set sequence number, so
+// lookups take no lock at all. Other types take a shared lock on the
+// set's shard. Inserts are best effort: one that finds its shard busy is
+// skipped rather than waiting.
+template<typename T, typename Hash = std::hash<T>>
+class MemoCache {
+public:
+    static constexpr size_t kWays = 4;
+
+    enum class Lookup { MISS, KEPT, DROPPED };
+
+    explicit MemoCache(size_t capacity, Hash hash = Hash())
+        : hash_(hash),
+          setMask_(roundUpToPowerOfTwo(std::max<size_t>(capacity / kWays, 1)) - 1),
+          sets_(new Set[setMask_ + 1]) {}
+
+    MemoCache(const MemoCache&) = delete;
+    MemoCache& operator=(const MemoCache&) = delete;
+
+    // Copies the cached result of key into value (left alone if dropped)
+    Lookup find(const T& key, T& value) const {
+        uint64_t tag = tagOf(key);
+        const Set& set = sets_[tag & setMask_];
+        if constexpr (kLockFree) {
+            uint32_t version = set.version.load(std::memory_order_acquire);
+            if (version & 1) {
+                return Lookup::MISS; // Being written
+            }
+            uint64_t keyBits = toBits(key);
+            for (size_t way = 0; way < kWays; ++way) {
+                if (set.tags[way].load(std::memory_order_relaxed) != tag ||
+                    set.keys[way].load(std::memory_order_relaxed) != keyBits) {
+                    continue;
+                }
+                uint64_t valueBits = set.values[way].load(std::memory_order_relaxed);
+                bool kept = set.kept[way].load(std::memory_order_relaxed) != 0;
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (set.version.load(std::memory_order_relaxed) != version) {
+                    return Lookup::MISS;
+                }
+                set.referenced[way].store(1, std::memory_order_relaxed);
+                if (!kept) return Lookup::DROPPED;
+                value = fromBits(valueBits);
+                return Lookup::KEPT;
+            }
+            return Lookup::MISS;
+        } else {
+            std::shared_lock<std::shared_mutex> lock(shardOf(tag).mutex);
+            for (size_t way = 0; way < kWays; ++way) {
+                if (set.tags[way] != tag || !(set.keys[way] == key)) {
+                    continue;
+                }
+                set.referenced[way].store(1, std::memory_order_relaxed);
+                if (!set.kept[way]) return Lookup::DROPPED;
+                value = set.values[way];
+                return Lookup::KEPT;
+            }
+            return Lookup::MISS;
+        }
+    }
+
+    // Remember that key gives value (kept) or is dropped (!kept)
+    void insert(const T& key, const T& value, bool kept) {
+        uint64_t tag = tagOf(key);
+        Set& set = sets_[tag & setMask_];
+        std::unique_lock<Mutex> lock(shardOf(tag).mutex, std::try_to_lock);
+        if (!lock.owns_lock()) {
+            return;
+        }
+        size_t way = chooseWay(set, tag, key);
+        if constexpr (kLockFree) {
+            uint32_t version = set.version.load(std::memory_order_relaxed);
+            set.version.store(version + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            set.tags[way].store(tag, std::memory_order_relaxed);
+            set.keys[way].store(toBits(key), std::memory_order_relaxed);
+            set.values[way].store(kept ? toBits(value) : 0, std::memory_order_relaxed);
+            set.kept[way].store(kept ? 1 : 0, std::memory_order_relaxed);
+            set.version.store(version + 2, std::memory_order_release);
+        } else {
+            set.tags[way] = tag;
+            set.keys[way] = key;
+            set.values[way] = kept ? value : T();
+            set.kept[way] = kept ? 1 : 0;
+        }
+        set.referenced[way].store(0, std::memory_order_relaxed);
+    }
+
+    void clear() {
+        for (auto& shard : shards_) {
+            shard.mutex.lock();
+        }
+        for (size_t i = 0; i <= setMask_; ++i) {
+            Set& set = sets_[i];
+            if constexpr (kLockFree) {
+                uint32_t version = set.version.load(std::memory_order_relaxed);
+                set.version.store(version + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+                for (auto& tag : set.tags) tag.store(kEmpty, std::memory_order_relaxed);
+                set.version.store(version + 2, std::memory_order_release);
+            } else {
+                for (size_t way = 0; way < kWays; ++way) {
+                    set.tags[way] = kEmpty;
+                    set.keys[way] = T();
+                    set.values[way] = T();
+                }
+            }
+        }
+        for (auto& shard : shards_) {
+            shard.mutex.unlock();
+        }
+    }
+
+    // Entries the cache can hold
+    size_t capacity() const {
+        return (setMask_ + 1) * kWays;
+    }
+
+    // Footprint of the table itself (heap data owned by cached values,
+    // such as string contents, comes on top)
+    size_t memoryBytes() const {
+        return (setMask_ + 1) * sizeof(Set);
+    }
+
+    bool lockFreeReads() const {
+        return kLockFree;
+    }
+
+    // Mixed hash; never kEmpty. std::hash is the identity for integers,
+    // which would put a run of small keys into neighbouring sets only.
+    uint64_t tagOf(const T& key) const {
+        uint64_t x = static_cast<uint64_t>(hash_(key));
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x | (uint64_t(1) << 63);
+    }
+
+    // Whether a and b are the same key. Bitwise for the lock-free types,
+    // so -0.0 and 0.0 stay apart and a NaN matches itself.
+    static bool sameKey(const T& a, const T& b) {
+        if constexpr (kLockFree) {
+            return toBits(a) == toBits(b);
+        } else {
+            return a == b;
+        }
+    }
+
+private:
+    static constexpr bool kLockFree = std::is_trivially_copyable<T>::value &&
+                                      sizeof(T) <= sizeof(uint64_t);
+    static constexpr size_t kShards = 64;
+    static constexpr uint64_t kEmpty = 0;
+
+    using Mutex = std::conditional_t<kLockFree, std::mutex, std::shared_mutex>;
+
+    struct alignas(kCacheLineSize) AtomicSet {
+        std::atomic<uint32_t> version{0};
+        uint8_t hand = 0; // Writers only, under the shard lock
+        mutable std::atomic<uint8_t> referenced[kWays] = {};
+        std::atomic<uint8_t> kept[kWays] = {};
+        std::atomic<uint64_t> tags[kWays] = {};
+        std::atomic<uint64_t> keys[kWays] = {};
+        std::atomic<uint64_t> values[kWays] = {};
+    };
+
+    struct alignas(kCacheLineSize) LockedSet {
+        uint8_t hand = 0;
+        mutable std::atomic<uint8_t> referenced[kWays] = {};
+        uint8_t kept[kWays] = {};
+        uint64_t tags[kWays] = {};
+        T keys[kWays] = {};
+        T values[kWays] = {};
+    };
+
+    using Set = std::conditional_t<kLockFree, AtomicSet, LockedSet>;
+
+    struct alignas(kCacheLineSize) Shard {
+        mutable Mutex mutex;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t capacity = 1;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    static uint64_t toBits(const T& value) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        return bits;
+    }
+
+    static T fromBits(uint64_t bits) {
+        T value;
+        std::memcpy(&value, &bits, sizeof(T));
+        return value;
+    }
+
+    Shard& shardOf(uint64_t tag) const {
+        return shards_[(tag & setMask_) % kShards];
+    }
+
+    // The entry already holding key, else an empty one, else the CLOCK
+    // victim. Caller holds the shard lock.
+    size_t chooseWay(Set& set, uint64_t tag, const T& key) {
+        size_t empty = kWays;
+        for (size_t way = 0; way < kWays; ++way) {
+            uint64_t current;
+            bool same;
+            if constexpr (kLockFree) {
+                current = set.tags[way].load(std::memory_order_relaxed);
+                same = current == tag && set.keys[way].load(std::memory_order_relaxed) == toBits(key);
+            } else {
+                current = set.tags[way];
+                same = current == tag && set.keys[way] == key;
+            }
+            if (same) return way;
+            if (current == kEmpty && empty == kWays) empty = way;
+        }
+        if (empty != kWays) return empty;
+
+        for (;;) {
+            size_t way = set.hand;
+            set.hand = static_cast<uint8_t>((way + 1) % kWays);
+            if (set.referenced[way].load(std::memory_order_relaxed) == 0) {
+                return way;
+            }
+            set.referenced[way].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    Hash hash_;
+    size_t setMask_;
+    std::unique_ptr<Set[]> sets_;
+    mutable Shard shards_[kShards];
+};
+
+// Memoizes a pure processor (Processor::isPure()): each input is
+// computed once and later occurrences come from a MemoCache, which pays
+// off when inputs repeat and the processor is expensive. Cheap SIMD
+// kernels such as NumericProcessor<double> are faster than the lookup.
+// Batches look every item up and hand the distinct misses, as one batch, to
+// the wrapped processor's batch kernel. Clones share the cache. Hits and
+// misses appear in ProcessingSystem::Statistics.
+template<typename T, typename Hash = std::hash<T>>
+class CachingProcessor : public Processor<T> {
+public:
+    using Cache = MemoCache<T, Hash>;
+    static constexpr size_t kDefaultCapacity = 4096;
+
+    explicit CachingProcessor(std::shared_ptr<Processor<T>> inner,
+                              size_t capacity = kDefaultCapacity)
+        : CachingProcessor(inner, std::make_shared<Counted>(capacity)) {
+        if (!inner_->isPure()) {
+            LOG_WARNING(inner_->getName() + " is not pure; results will not be cached");
+        }
+    }
+
+    T process(const T& input) override {
+        std::optional<T> result = tryProcess(input);
+        return result ? std::move(*result) : T();
+    }
+
+    std::optional<T> tryProcess(const T& input) override {
+        if (!enabled_) {
+            return inner_->tryProcess(input);
+        }
+        T value;
+        switch (memo().find(input, value)) {
+        case Cache::Lookup::KEPT:
+            shared_->hits.add();
+            return value;
+        case Cache::Lookup::DROPPED:
+            shared_->hits.add();
+            return std::nullopt;
+        case Cache::Lookup::MISS:
+            break;
+        }
+        shared_->misses.add();
+        std::optional<T> result = inner_->tryProcess(input);
+        memo().insert(input, result ? *result : T(), result.has_value());
+        return result;
+    }
+
+    void processBatch(const T* in, T* out, size_t n) override {
+        if (!enabled_) {
+            inner_->processBatch(in, out, n);
+            return;
+        }
+        if (inner_->dropsItems()) {
+            // Keep the drop verdicts for the cache; dropped items read T()
+            Processor<T>::processBatch(in, out, n);
+            return;
+        }
+        ScratchScope scratch;
+        Misses misses(scratch, n);
+        ArenaVector<size_t> missAt(scratch.allocator<size_t>());
+        missAt.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            T value;
+            if (memo().find(in[i], value) == Cache::Lookup::KEPT) {
+                out[i] = std::move(value);
+            } else {
+                missAt.push_back(i);
+                misses.add(memo(), in[i]);
+            }
+        }
+        size_t unique = misses.keys.size();
+        count(n, unique);
+        if (unique == 0) return;
+
+        ArenaVector<T> results(unique, T(), scratch.allocator<T>());
+        inner_->processBatch(misses.keys.data(), results.data(), unique);
+        for (size_t u = 0; u < unique; ++u) {
+            memo().insert(misses.keys[u], results[u], true);
+        }
+        for (size_t j = 0; j < missAt.size(); ++j) {
+            out[missAt[j]] = results[misses.keyOf[j]];
+        }
+    }
+
+    bool dropsItems() const override {
+        return inner_->dropsItems();
+    }
+
+    size_t processBatchFiltered(const T* in, T* out, uint8_t* keep, size_t n) override {
+        if (!enabled_) {
+            return inner_->processBatchFiltered(in, out, keep, n);
+        }
+        ScratchScope scratch;
+        // Pass 1: look everything up; hits go to hitValues, misses queue up
+        ArenaVector<T> hitValues(n, T(), scratch.allocator<T>());
+        ArenaVector<uint8_t> outcome(n, 0, scratch.allocator<uint8_t>());
+        Misses misses(scratch, n);
+        for (size_t i = 0; i < n; ++i) {
+            switch (memo().find(in[i], hitValues[i])) {
+            case Cache::Lookup::KEPT:
+                outcome[i] = kHitKept;
+                break;
+            case Cache::Lookup::DROPPED:
+                outcome[i] = kHitDropped;
+                break;
+            case Cache::Lookup::MISS:
+                outcome[i] = kMiss;
+                misses.add(memo(), in[i]);
+                break;
+            }
+        }
+        size_t unique = misses.keys.size();
+        count(n, unique);
+
+        // Each distinct miss once; resultAt[u] finds its compacted result
+        ArenaVector<T> results(unique, T(), scratch.allocator<T>());
+        ArenaVector<uint8_t> kept(unique, 0, scratch.allocator<uint8_t>());
+        ArenaVector<size_t> resultAt(unique, 0, scratch.allocator<size_t>());
+        if (unique > 0) {
+            inner_->processBatchFiltered(misses.keys.data(), results.data(), kept.data(), unique);
+            for (size_t u = 0, next = 0; u < unique; ++u) {
+                resultAt[u] = next;
+                memo().insert(misses.keys[u], kept[u] ? results[next] : T(), kept[u] != 0);
+                next += kept[u] ? 1 : 0;
+            }
+        }
+
+        // Pass 2: merge in input order. in[i] was fully read in pass 1, so
+        // writing out[total] (total <= i) is safe even when out aliases in.
+        size_t total = 0;
+        size_t miss = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (outcome[i] == kMiss) {
+                size_t u = misses.keyOf[miss++];
+                keep[i] = kept[u];
+                if (kept[u]) out[total++] = results[resultAt[u]];
+            } else {
+                keep[i] = outcome[i] == kHitKept ? 1 : 0;
+                if (keep[i]) out[total++] = std::move(hitValues[i]);
+            }
+        }
+        return total;
+    }
+
+    std::string getName() const override {
+        return "Cached(" + inner_->getName() + ")";
+    }
+
+    // Without the cache this is a pass-through, so it is exactly as
+    // stateless, pure and checkpointable as the wrapped processor
+    bool isStateless() const override {
+        return enabled_ || inner_->isStateless();
+    }
+
+    bool isPure() const override {
+        return enabled_ || inner_->isPure();
+    }
+
+    bool canRetryBatch() const override {
+        return enabled_ || inner_->canRetryBatch();
+    }
+
+    bool needsInputOrder() const override {
+        return !enabled_ && inner_->needsInputOrder();
+    }
+
+    bool snapshot(ByteWriter& out) const override {
+        return enabled_ ? Processor<T>::snapshot(out) : inner_->snapshot(out);
+    }
+
+    bool restore(ByteReader& in) override {
+        return enabled_ ? Processor<T>::restore(in) : inner_->restore(in);
+    }
+
+    // A stateful inner processor is cloned too, so clones never share its state
+    std::shared_ptr<Processor<T>> clone() const override {
+        if (enabled_) {
+            return std::shared_ptr<Processor<T>>(new CachingProcessor(inner_, shared_));
+        }
+        auto inner = inner_->clone();
+        return inner ? std::shared_ptr<Processor<T>>(new CachingProcessor(inner, shared_)) : nullptr;
+    }
+
+    // Forget every cached result; the counters keep running
+    void reset() override {
+        memo().clear();
+        inner_->reset();
+        Processor<T>::reset();
+    }
+
+    CacheCounters cacheCounters() const override {
+        CacheCounters counters = inner_->cacheCounters();
+        counters.hits += shared_->hits.load();
+        counters.misses += shared_->misses.load();
+        return counters;
+    }
+
+    const Cache& cache() const {
+        return shared_->cache;
+    }
+
+private:
+    static constexpr uint8_t kMiss = 0;
+    static constexpr uint8_t kHitKept = 1;
+    static constexpr uint8_t kHitDropped = 2;
+
+    // A batch's misses with repeats folded together, so a key that is
+    // hot within one batch is still computed once
+    struct Misses {
+        Misses(ScratchScope& scratch, size_t n)
+            : keys(scratch.allocator<T>()),
+              keyOf(scratch.allocator<size_t>()),
+              slots(tableSize(n), 0, scratch.allocator<size_t>()) {
+            keys.reserve(n);
+            keyOf.reserve(n);
+        }
+
+        void add(const Cache& cache, const T& key) {
+            size_t mask = slots.size() - 1;
+            size_t slot = static_cast<size_t>(cache.tagOf(key)) & mask;
+            while (slots[slot] != 0 && !Cache::sameKey(keys[slots[slot] - 1], key)) {
+                slot = (slot + 1) & mask;
+            }
+            if (slots[slot] == 0) {
+                keys.push_back(key);
+                slots[slot] = keys.size();
+            }
+            keyOf.push_back(slots[slot] - 1);
+        }
+
+        // At most half full
+        static size_t tableSize(size_t n) {
+            size_t size = 2;
+            while (size < 2 * n) size <<= 1;
+            return size;
+        }
+
+        ArenaVector<T> keys;       // Distinct missed keys, first seen first
+        ArenaVector<size_t> keyOf; // Per missed item: index into keys
+        ArenaVector<size_t> slots; // Open addressing: index into keys + 1
+    };
+
+    // What clones share
+    struct Counted {
+        explicit Counted(size_t capacity) : cache(capacity) {}
+        Cache cache;
+        ShardedCounter hits;
+        ShardedCounter misses;
+    };
+
+    CachingProcessor(std::shared_ptr<Processor<T>> inner, std::shared_ptr<Counted> shared)
+        : inner_(std::move(inner)), shared_(std::move(shared)), enabled_(inner_->isPure()) {}
+
+    Cache& memo() {
+        return shared_->cache;
+    }
+
+    void count(size_t looked, size_t missed) {
+        if (looked > missed) shared_->hits.add(looked - missed);
+        if (missed > 0) shared_->misses.add(missed);
+    }
+
+    std::shared_ptr<Processor<T>> inner_;
+    std::shared_ptr<Counted> shared_;
+    bool enabled_;
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+
+class ByteWriter;
+class ByteReader;
+
+// How a value is written to a checkpoint. Trivially copyable types go
+// out as raw bytes in native byte order (checkpoints are meant to be
+// read back by the same build on the same kind of machine, like
+// FileSource input); std::string and std::vector are length-prefixed.
+// Specialize for other payload types:
+//
+//   template<> struct Codec<Reading> {
+//       static void write(ByteWriter& out, const Reading& value);
+//       static bool read(ByteReader& in, Reading& value);
+//   };
+template<typename T, typename Enable = void>
+struct Codec;
+
+// Growing byte buffer that checkpoint data is encoded into. Counts,
+// lengths and keys are LEB128 varints, so small numbers take one byte.
+class ByteWriter {
+public:
+    void writeBytes(const void* data, size_t n) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        bytes_.insert(bytes_.end(), bytes, bytes + n);
+    }
+
+    void writeVarint(uint64_t value) {
+        while (value >= 0x80) {
+            bytes_.push_back(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        bytes_.push_back(static_cast<uint8_t>(value));
+    }
+
+    template<typename T>
+    void write(const T& value) {
+        Codec<T>::write(*this, value);
+    }
+
+    // A nested blob, length first, so a reader can skip or bound it
+    void writeBlob(const std::vector<uint8_t>& blob) {
+        writeVarint(blob.size());
+        writeBytes(blob.data(), blob.size());
+    }
+
+    const std::vector<uint8_t>& bytes() const {
+        return bytes_;
+    }
+
+    std::vector<uint8_t>& bytes() {
+        return bytes_;
+    }
+
+    size_t size() const {
+        return bytes_.size();
+    }
+
+private:
+    std::vector<uint8_t> bytes_;
+};
+
+// Reads what a ByteWriter wrote. Every read returns false once the data
+// runs out or is malformed, and the reader stays failed from then on, so
+// callers can check once at the end.
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    explicit ByteReader(const std::vector<uint8_t>& bytes)
+        : ByteReader(bytes.data(), bytes.size()) {}
+
+    bool readBytes(void* out, size_t n) {
+        if (failed_ || size_ - offset_ < n) {
+            failed_ = true;
+            return false;
+        }
+        std::memcpy(out, data_ + offset_, n);
+        offset_ += n;
+        return true;
+    }
+
+    bool readVarint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte;
+            if (!readBytes(&byte, 1)) return false;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        failed_ = true;
+        return false;
+    }
+
+    template<typename T>
+    bool read(T& value) {
+        return !failed_ && Codec<T>::read(*this, value);
+    }
+
+    // Count of elements about to be read; refuses counts that could not
+    // fit in what is left, so a corrupt count cannot trigger a huge
+    // allocation
+    bool readCount(uint64_t& count, size_t minBytesEach = 1) {
+        if (!readVarint(count)) return false;
+        if (count > remaining() / std::max<size_t>(minBytesEach, 1)) {
+            failed_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool readBlob(std::vector<uint8_t>& blob) {
+        uint64_t n;
+        if (!readCount(n)) return false;
+        blob.assign(data_ + offset_, data_ + offset_ + n);
+        offset_ += static_cast<size_t>(n);
+        return true;
+    }
+
+    size_t remaining() const {
+        return size_ - offset_;
+    }
+
+    bool atEnd() const {
+        return offset_ == size_;
+    }
+
+    bool failed() const {
+        return failed_;
+    }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_ = 0;
+    bool failed_ = false;
+};
+
+template<typename T>
+struct Codec<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    static void write(ByteWriter& out, const T& value) {
+        out.writeBytes(&value, sizeof(T));
+    }
+
+    static bool read(ByteReader& in, T& value) {
+        return in.readBytes(&value, sizeof(T));
+    }
+};
+
+template<>
+struct Codec<std::string> {
+    static void write(ByteWriter& out, const std::string& value) {
+        out.writeVarint(value.size());
+        out.writeBytes(value.data(), value.size());
+    }
+
+    static bool read(ByteReader& in, std::string& value) {
+        uint64_t n;
+        if (!in.readCount(n)) return false;
+        value.resize(static_cast<size_t>(n));
+        return in.readBytes(&value[0], value.size());
+    }
+};
+
+template<typename T>
+struct Codec<std::vector<T>> {
+    static void write(ByteWriter& out, const std::vector<T>& values) {
+        out.writeVarint(values.size());
+        for (const auto& value : values) {
+            out.write(value);
+        }
+    }
+
+    static bool read(ByteReader& in, std::vector<T>& values) {
+        uint64_t n;
+        if (!in.readCount(n)) return false;
+        values.clear();
+        values.reserve(static_cast<size_t>(n));
+        for (uint64_t i = 0; i < n; ++i) {
+            T value;
+            if (!in.read(value)) return false;
+            values.push_back(std::move(value));
+        }
+        return true;
+    }
+};
+
+// 64-bit FNV-1a, enough to catch a torn or truncated checkpoint file
+inline uint64_t checksum64(const uint8_t* data, size_t n) {
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < n; ++i) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI // wingdi.h defines ERROR, which breaks LOG_ERROR
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Logger.h"
+
+// Checkpoint files, kept out of Checkpoint.h so that Processor.h and
+// everything including it do not pull in the platform headers
+
+// Write bytes to path via a temporary file that is flushed to disk and
+// then renamed over path, so path always holds a complete checkpoint:
+// the old one or the new one
+inline bool writeFileAtomically(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR("Cannot create " + temporary);
+        return false;
+    }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size() &&
+              std::fflush(file) == 0;
+#if !defined(_WIN32)
+    ok = ok && ::fsync(::fileno(file)) == 0;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+#if defined(_WIN32)
+    ok = ok && MoveFileExA(temporary.c_str(), path.c_str(),
+                           MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    ok = ok && std::rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+    if (!ok) {
+        LOG_ERROR("Write to " + path + " failed");
+        std::remove(temporary.c_str());
+    }
+    return ok;
+}
+
+inline bool readFile(const std::string& path, std::vector<uint8_t>& bytes) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        LOG_ERROR("Cannot open " + path);
+        return false;
+    }
+    bytes.clear();
+    uint8_t buffer[1 << 16];
+    size_t n;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    bool ok = !std::ferror(file);
+    std::fclose(file);
+    if (!ok) {
+        LOG_ERROR("Read from " + path + " failed");
+    }
+    return ok;
+}
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <tuple>
+#include <array>
+#include <map>
+#include <string>
+#include <utility>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+
+#include "Processor.h"
+#include "ProcessorFactory.h"
+#include "Allocators.h"
+#include "Logger.h"
+
+// Column types of a record, in order: Schema<int64_t, float, double>
+template<typename... Columns>
+struct Schema {
+    static constexpr size_t kColumnCount = sizeof...(Columns);
+
+    template<size_t I>
+    using Column = std::tuple_element_t<I, std::tuple<Columns...>>;
+};
+
+// Up to Capacity records stored column by column (struct of arrays), so
+// a processor that reads one field streams through just that field.
+// Every column and every validity bitmap (one bit per row, set = valid)
+// starts on its own 64-byte boundary. All columns share one allocation,
+// made on first use, so a chunk moves through a queue as a few words.
+template<typename SchemaT, size_t Capacity = 1024>
+class Chunk;
+
+template<size_t Capacity, typename... Columns>
+class Chunk<Schema<Columns...>, Capacity> {
+    static_assert(sizeof...(Columns) > 0, "A schema needs at least one column");
+    static_assert(Capacity > 0 && Capacity % 64 == 0, "Capacity must be a multiple of 64 rows");
+    static_assert((std::is_trivially_copyable<Columns>::value && ...),
+                  "Columns hold raw values");
+
+public:
+    using SchemaType = Schema<Columns...>;
+    static constexpr size_t kCapacity = Capacity;
+    static constexpr size_t kColumnCount = sizeof...(Columns);
+    static constexpr size_t kAlignment = 64;
+
+    template<size_t I>
+    using Column = typename SchemaType::template Column<I>;
+
+    Chunk() = default;
+
+    Chunk(const Chunk& other) : size_(other.size_) {
+        if (other.storage_) {
+            allocate();
+            std::memcpy(storage_.get(), other.storage_.get(), kStorageBytes);
+        }
+    }
+
+    Chunk& operator=(const Chunk& other) {
+        if (this != &other) {
+            if (!other.storage_) {
+                storage_.reset();
+            } else {
+                if (!storage_) allocate();
+                std::memcpy(storage_.get(), other.storage_.get(), kStorageBytes);
+            }
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    Chunk(Chunk&& other) noexcept
+        : storage_(std::move(other.storage_)), size_(other.size_) {
+        other.size_ = 0;
+    }
+
+    Chunk& operator=(Chunk&& other) noexcept {
+        storage_ = std::move(other.storage_);
+        size_ = other.size_;
+        other.size_ = 0;
+        return *this;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool full() const { return size_ == Capacity; }
+
+    // Append one record with every field valid. Returns false when full.
+    bool append(const Columns&... values) {
+        if (full()) return false;
+        if (!storage_) allocate();
+        size_t row = size_;
+        appendFields(row, std::index_sequence_for<Columns...>(), values...);
+        ++size_;
+        return true;
+    }
+
+    // Grow to rows, marking the new rows valid; for filling columns
+    // directly through column<I>()
+    void resize(size_t rows) {
+        if (rows > Capacity) rows = Capacity;
+        if (!storage_) allocate();
+        for (size_t row = size_; row < rows; ++row) {
+            setAllValid(row, std::index_sequence_for<Columns...>());
+        }
+        size_ = rows;
+    }
+
+    void clear() {
+        size_ = 0;
+    }
+
+    template<size_t I>
+    Column<I>* column() {
+        if (!storage_) allocate();
+        return reinterpret_cast<Column<I>*>(storage_.get() + kColumnOffsets[I]);
+    }
+
+    template<size_t I>
+    const Column<I>* column() const {
+        return storage_ ? reinterpret_cast<const Column<I>*>(storage_.get() + kColumnOffsets[I])
+                        : nullptr;
+    }
+
+    template<size_t I>
+    uint64_t* validity() {
+        if (!storage_) allocate();
+        return bitmap(I);
+    }
+
+    template<size_t I>
+    const uint64_t* validity() const {
+        return storage_ ? bitmap(I) : nullptr;
+    }
+
+    template<size_t I>
+    bool isValid(size_t row) const {
+        return (validity<I>()[row / 64] >> (row % 64)) & 1;
+    }
+
+    template<size_t I>
+    void setNull(size_t row) {
+        validity<I>()[row / 64] &= ~(uint64_t(1) << (row % 64));
+    }
+
+    template<size_t I>
+    void setValid(size_t row) {
+        validity<I>()[row / 64] |= uint64_t(1) << (row % 64);
+    }
+
+    // Keep only the rows with keep[row] != 0, in order, in every column
+    void compact(const uint8_t* keep) {
+        if (!storage_) return;
+        size_t kept = 0;
+        for (size_t row = 0; row < size_; ++row) {
+            if (keep[row]) {
+                if (kept != row) {
+                    moveRow(row, kept, std::index_sequence_for<Columns...>());
+                }
+                ++kept;
+            }
+        }
+        size_ = kept;
+    }
+
+private:
+    static constexpr size_t kBitmapBytes = Capacity / 8;
+
+    static constexpr size_t alignUp(size_t n) {
+        return (n + kAlignment - 1) / kAlignment * kAlignment;
+    }
+
+    // Column I starts after every earlier column, each padded to 64 bytes
+    static constexpr std::array<size_t, kColumnCount> columnOffsets() {
+        std::array<size_t, kColumnCount> offsets{};
+        size_t sizes[] = {sizeof(Columns)...};
+        size_t offset = 0;
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            offsets[i] = offset;
+            offset += alignUp(sizes[i] * Capacity);
+        }
+        return offsets;
+    }
+
+    static constexpr size_t bitmapOffset() {
+        size_t sizes[] = {sizeof(Columns)...};
+        size_t offset = 0;
+        for (size_t i = 0; i < kColumnCount; ++i) {
+            offset += alignUp(sizes[i] * Capacity);
+        }
+        return offset;
+    }
+
+    static constexpr std::array<size_t, kColumnCount> kColumnOffsets = columnOffsets();
+    static constexpr size_t kBitmapOffset = bitmapOffset();
+    static constexpr size_t kStorageBytes = kBitmapOffset + kColumnCount * alignUp(kBitmapBytes);
+
+    struct AlignedDelete {
+        void operator()(uint8_t* memory) const {
+            ::operator delete(memory, std::align_val_t(kAlignment));
+        }
+    };
+
+    void allocate() {
+        storage_.reset(static_cast<uint8_t*>(::operator new(kStorageBytes, std::align_val_t(kAlignment))));
+        std::memset(storage_.get() + kBitmapOffset, 0, kStorageBytes - kBitmapOffset);
+    }
+
+    uint64_t* bitmap(size_t column) const {
+        return reinterpret_cast<uint64_t*>(storage_.get() + kBitmapOffset +
+                                           column * alignUp(kBitmapBytes));
+    }
+
+    template<size_t... I>
+    void appendFields(size_t row, std::index_sequence<I...>, const Columns&... values) {
+        ((column<I>()[row] = values, setValid<I>(row)), ...);
+    }
+
+    template<size_t... I>
+    void setAllValid(size_t row, std::index_sequence<I...>) {
+        (setValid<I>(row), ...);
+    }
+
+    template<size_t... I>
+    void moveRow(size_t from, size_t to, std::index_sequence<I...>) {
+        ((column<I>()[to] = column<I>()[from],
+          isValid<I>(from) ? setValid<I>(to) : setNull<I>(to)), ...);
+    }
+
+    std::unique_ptr<uint8_t[], AlignedDelete> storage_;
+    size_t size_ = 0;
+};
+
+// Runs a scalar processor over column I of each chunk through its batch
+// kernel, in place, so FilteringProcessor and AmplificationProcessor get
+// their SIMD paths on a chunk stream. A processor that drops items drops
+// rows: whole rows go, in every column, as do rows whose value in column
+// I is null. A processor that is not pure only sees the valid rows, so
+// stale values in null slots never reach its state. Chunks are never
+// dropped, even when they end up empty.
+template<typename ChunkT, size_t I>
+class ColumnProcessor : public Processor<ChunkT> {
+public:
+    using Value = typename ChunkT::template Column<I>;
+
+    explicit ColumnProcessor(std::shared_ptr<Processor<Value>> inner) : inner_(std::move(inner)) {}
+
+    ColumnProcessor(ProcessorType type, const std::map<std::string, double>& params = {})
+        : inner_(ProcessorFactory<Value>::getInstance().createProcessor(type, params)) {}
+
+    explicit ColumnProcessor(const ProcessorConfig& config)
+        : inner_(ProcessorFactory<Value>::getInstance().createProcessor(config)) {}
+
+    ChunkT process(const ChunkT& input) override {
+        ChunkT result = input;
+        processInPlace(result);
+        return result;
+    }
+
+    void processInPlace(ChunkT& chunk) override {
+        size_t n = chunk.size();
+        if (n == 0) return;
+        Value* values = chunk.template column<I>();
+
+        if (!inner_->isPure()) {
+            processValidRows(chunk, values, n);
+            return;
+        }
+
+        if (!inner_->dropsItems()) {
+            inner_->processBatch(values, values, n);
+            return;
+        }
+
+        ScratchScope scratch;
+        ArenaVector<uint8_t> keep(n, 0, scratch.allocator<uint8_t>());
+        ArenaVector<Value> kept(n, Value(), scratch.allocator<Value>());
+        inner_->processBatchFiltered(values, kept.data(), keep.data(), n);
+
+        // The k-th kept value is the result for the k-th kept row
+        size_t next = 0;
+        for (size_t row = 0; row < n; ++row) {
+            if (!keep[row]) continue;
+            values[row] = kept[next++];
+            if (!chunk.template isValid<I>(row)) keep[row] = 0;
+        }
+        chunk.compact(keep.data());
+    }
+
+    bool processesInPlace() const override {
+        return true;
+    }
+
+    bool isStateless() const override {
+        return inner_->isStateless();
+    }
+
+    bool needsInputOrder() const override {
+        return inner_->needsInputOrder();
+    }
+
+    bool isPure() const override {
+        return inner_->isPure();
+    }
+
+    CacheCounters cacheCounters() const override {
+        return inner_->cacheCounters();
+    }
+
+    bool snapshot(ByteWriter& out) const override {
+        return inner_->snapshot(out);
+    }
+
+    bool restore(ByteReader& in) override {
+        return inner_->restore(in);
+    }
+
+    std::string getName() const override {
+        return "Column" + std::to_string(I) + "(" + inner_->getName() + ")";
+    }
+
+    std::shared_ptr<Processor<ChunkT>> clone() const override {
+        auto inner = inner_->clone();
+        return inner ? std::make_shared<ColumnProcessor>(inner) : nullptr;
+    }
+
+    void reset() override {
+        inner_->reset();
+    }
+
+private:
+    // Gather the valid rows, run the batch over them and scatter the
+    // results back. Null rows are dropped if the processor drops items.
+    void processValidRows(ChunkT& chunk, Value* values, size_t n) {
+        ScratchScope scratch;
+        ArenaVector<size_t> rows(scratch.allocator<size_t>());
+        ArenaVector<Value> valid(scratch.allocator<Value>());
+        rows.reserve(n);
+        valid.reserve(n);
+        for (size_t row = 0; row < n; ++row) {
+            if (chunk.template isValid<I>(row)) {
+                rows.push_back(row);
+                valid.push_back(values[row]);
+            }
+        }
+        size_t count = rows.size();
+
+        if (!inner_->dropsItems()) {
+            if (count == 0) return;
+            inner_->processBatch(valid.data(), valid.data(), count);
+            for (size_t k = 0; k < count; ++k) {
+                values[rows[k]] = valid[k];
+            }
+            return;
+        }
+
+        ArenaVector<uint8_t> keep(n, 0, scratch.allocator<uint8_t>());
+        if (count > 0) {
+            ArenaVector<uint8_t> validKeep(count, 0, scratch.allocator<uint8_t>());
+            ArenaVector<Value> kept(count, Value(), scratch.allocator<Value>());
+            inner_->processBatchFiltered(valid.data(), kept.data(), validKeep.data(), count);
+            size_t next = 0;
+            for (size_t k = 0; k < count; ++k) {
+                if (!validKeep[k]) continue;
+                values[rows[k]] = kept[next++];
+                keep[rows[k]] = 1;
+            }
+        }
+        chunk.compact(keep.data());
+    }
+
+    std::shared_ptr<Processor<Value>> inner_;
+};
@@ -1,116 +1,344 @@
 #pragma once
 
-#include <queue>
-#include <deque>
 #include <mutex>
 #include <condition_variable>
 #include <memory>
 #include <optional>
 #include <chrono>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
 
+#include "Allocators.h"
+#include "Metrics.h"
+
+// One priority lane of a DataQueue: its own bound, and how many items it
+// may hand out per round-robin turn
+struct LaneConfig {
+    size_t capacity = 0;
+    unsigned weight = 1;
+};
+
+struct LaneStats {
+    size_t depth = 0;
+    size_t capacity = 0;
+    unsigned weight = 1;
+    uint64_t totalEnqueued = 0;
+    uint64_t totalDequeued = 0;
+    LatencyHistogram::Snapshot wait; // Time spent queued; multi-lane queues only
+};
+
+// Items live in a SlabRing, so a queue that has reached its working depth
+// stops allocating. The first kPreallocatedSlots slots exist up front.
+//
+// A queue starts with a single lane and is then strictly FIFO.
+// configureLanes() splits it into priority lanes, each a bounded ring of
+// its own. Consumers take from the lanes by deficit round-robin: on its
+// turn a lane hands out up to weight items before the next lane's turn,
+// so a deep low-priority lane delays a high-priority item by at most one
+// round, and no lane with items ever starves. The plain enqueue calls
+// use lane 0; lane(i) enqueues elsewhere.
 template<typename T>
 class DataQueue {
 public:
-    explicit DataQueue(size_t maxSize = 10000) 
-        : maxSize_(maxSize), shutdown_(false) {}
+    static constexpr size_t kPreallocatedSlots = 1024;
+
+    explicit DataQueue(size_t maxSize = 10000)
+        : maxSize_(maxSize), size_(0), current_(0), timed_(false),
+          shutdown_(false), totalEnqueued_(0), totalDequeued_(0) {
+        lanes_.push_back(std::make_unique<Lane>(LaneConfig{maxSize, 1}, false));
+    }
 
     ~DataQueue() {
         shutdown();
     }
 
+    // Replace the lanes; lane 0 is the one the plain enqueue calls use.
+    // Only an empty queue can be reconfigured. Returns false, leaving the
+    // queue as it was, if it is not empty or a lane has no capacity.
+    // A weight of 0 counts as 1.
+    bool configureLanes(const std::vector<LaneConfig>& lanes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (lanes.empty() || size_ > 0) return false;
+        for (const auto& config : lanes) {
+            if (config.capacity == 0) return false;
+        }
+
+        timed_ = lanes.size() > 1;
+        lanes_.clear();
+        maxSize_ = 0;
+        for (const auto& config : lanes) {
+            lanes_.push_back(std::make_unique<Lane>(config, timed_));
+            maxSize_ += config.capacity;
+        }
+        current_ = 0;
+        return true;
+    }
+
+    size_t laneCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lanes_.size();
+    }
+
+    // Producer-side view of one lane for the enqueue calls, plus
+    // tryDequeue() of that lane's oldest item. Valid until the queue is
+    // reconfigured.
+    class LaneRef {
+    public:
+        bool enqueue(const T& item, int timeoutMs = -1) {
+            return queue_->emplaceTo(lane_, timeoutMs, item);
+        }
+
+        bool enqueue(T&& item, int timeoutMs = -1) {
+            return queue_->emplaceTo(lane_, timeoutMs, std::move(item));
+        }
+
+        template<typename... Args>
+        bool emplaceFor(int timeoutMs, Args&&... args) {
+            return queue_->emplaceTo(lane_, timeoutMs, std::forward<Args>(args)...);
+        }
+
+        template<typename InputIt>
+        size_t enqueueBulk(InputIt first, InputIt last, int timeoutMs = -1) {
+            return queue_->enqueueBulkTo(lane_, first, last, timeoutMs);
+        }
+
+        bool tryEnqueue(const T& item) {
+            return queue_->tryEmplaceTo(lane_, item);
+        }
+
+        bool tryEnqueue(T&& item) {
+            return queue_->tryEmplaceTo(lane_, std::move(item));
+        }
+
+        template<typename InputIt>
+        size_t tryEnqueueBulk(InputIt first, InputIt last) {
+            return queue_->tryEnqueueBulkTo(lane_, first, last);
+        }
+
+        std::optional<T> tryDequeue() {
+            return queue_->tryDequeueFrom(lane_);
+        }
+
+        bool isShutdown() const {
+            return queue_->isShutdown();
+        }
+
+    private:
+        friend class DataQueue;
+        LaneRef(DataQueue* queue, size_t lane) : queue_(queue), lane_(lane) {}
+
+        DataQueue* queue_;
+        size_t lane_;
+    };
+
+    // index must be below laneCount()
+    LaneRef lane(size_t index) {
+        return LaneRef(this, index);
+    }
+
     // Add item to queue
     bool enqueue(const T& item, int timeoutMs = -1) {
+        return emplaceFor(timeoutMs, item);
+    }
+
+    bool enqueue(T&& item, int timeoutMs = -1) {
+        return emplaceFor(timeoutMs, std::move(item));
+    }
+
+    // Construct an item in place, waiting as long as needed for room
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        return emplaceFor(-1, std::forward<Args>(args)...);
+    }
+
+    // Construct an item in place, waiting at most timeoutMs for room
+    template<typename... Args>
+    bool emplaceFor(int timeoutMs, Args&&... args) {
+        return emplaceTo(0, timeoutMs, std::forward<Args>(args)...);
+    }
+
+    // Retrieve and remove item from queue
+    std::optional<T> dequeue(int timeoutMs = -1) {
         std::unique_lock<std::mutex> lock(mutex_);
 
         if (timeoutMs > 0) {
-            if (!notFull_.wait_for(lock, 
+            if (!notEmpty_.wait_for(lock,
                 std::chrono::milliseconds(timeoutMs),
-                [this] { return queue_.size() < maxSize_ && !shutdown_; })) {
-                return false; // Timeout
+                [this] { return size_ > 0 || shutdown_; })) {
+                return std::nullopt; // Timeout
             }
         } else {
-            notFull_.wait(lock, [this] { 
-                return queue_.size() < maxSize_ && !shutdown_; 
+            notEmpty_.wait(lock, [this] {
+                return size_ > 0 || shutdown_;
             });
         }
 
-        if (shutdown_) return false;
+        if (size_ == 0) {
+            return std::nullopt;
+        }
 
-        queue_.push_back(item);
-        notEmpty_.notify_one();
-        return true;
+        Lane* from = nullptr;
+        T item = popLocked(timed_ ? monotonicNanos() : 0, from);
+        from->notFull.notify_one();
+        return item;
     }
 
-    // Retrieve and remove item from queue
-    std::optional<T> dequeue(int timeoutMs = -1) {
+    // Add a range of items, one lock and one notify per run of items that
+    // fit. Waits (up to timeoutMs overall) while the queue is full.
+    // Returns the number of items added.
+    template<typename InputIt>
+    size_t enqueueBulk(InputIt first, InputIt last, int timeoutMs = -1) {
+        return enqueueBulkTo(0, first, last, timeoutMs);
+    }
+
+    size_t enqueueBulk(const std::vector<T>& items, int timeoutMs = -1) {
+        return enqueueBulk(items.begin(), items.end(), timeoutMs);
+    }
+
+    // Moves the items in; the ones not accepted are left moved-from
+    size_t enqueueBulk(std::vector<T>&& items, int timeoutMs = -1) {
+        return enqueueBulk(std::make_move_iterator(items.begin()),
+                           std::make_move_iterator(items.end()), timeoutMs);
+    }
+
+    // Move up to maxItems into out with a single lock. Waits (up to
+    // timeoutMs) only until at least one item is available.
+    // Returns the number of items appended to out.
+    size_t dequeueBulk(std::vector<T>& out, size_t maxItems, int timeoutMs = -1) {
         std::unique_lock<std::mutex> lock(mutex_);
 
+        auto hasItems = [this] { return size_ > 0 || shutdown_; };
         if (timeoutMs > 0) {
-            if (!notEmpty_.wait_for(lock, 
-                std::chrono::milliseconds(timeoutMs),
-                [this] { return !queue_.empty() || shutdown_; })) {
-                return std::nullopt; // Timeout
+            if (!notEmpty_.wait_for(lock, std::chrono::milliseconds(timeoutMs), hasItems)) {
+                return 0; // Timeout
             }
         } else {
-            notEmpty_.wait(lock, [this] { 
-                return !queue_.empty() || shutdown_; 
-            });
+            notEmpty_.wait(lock, hasItems);
         }
 
-        if (queue_.empty()) {
-            return std::nullopt;
+        int64_t now = timed_ && size_ > 0 ? monotonicNanos() : 0;
+        Lane* from = nullptr;
+        size_t taken = 0;
+        while (taken < maxItems && size_ > 0) {
+            out.push_back(popLocked(now, from));
+            ++taken;
+        }
+
+        if (taken == 1) {
+            from->notFull.notify_one();
+        } else if (taken > 1) {
+            for (auto& lane : lanes_) {
+                lane->notFull.notify_all();
+            }
         }
+        return taken;
+    }
+
+    // Non-blocking variants. Like the waiting calls, they refuse new items
+    // once the queue is shut down.
+    bool tryEnqueue(const T& item) {
+        return tryEmplace(item);
+    }
+
+    bool tryEnqueue(T&& item) {
+        return tryEmplace(std::move(item));
+    }
 
-        T item = std::move(queue_.front());
-        queue_.pop_front();
-        notFull_.notify_one();
+    // The arguments are only consumed if there is room
+    template<typename... Args>
+    bool tryEmplace(Args&&... args) {
+        return tryEmplaceTo(0, std::forward<Args>(args)...);
+    }
+
+    // Add as many items as fit right now; the rest are left untouched
+    template<typename InputIt>
+    size_t tryEnqueueBulk(InputIt first, InputIt last) {
+        return tryEnqueueBulkTo(0, first, last);
+    }
+
+    std::optional<T> tryDequeue() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+        Lane* from = nullptr;
+        T item = popLocked(timed_ ? monotonicNanos() : 0, from);
+        from->notFull.notify_one();
         return item;
     }
 
-    // Peek at front item without removing
+    // Peek at the item the next dequeue would return
     std::optional<T> peek() {
         std::lock_guard<std::mutex> lock(mutex_);
-        if (queue_.empty()) {
+        if (size_ == 0) {
             return std::nullopt;
         }
-        return queue_.front();
+        for (size_t i = 0; ; ++i) {
+            Lane& lane = *lanes_[(current_ + i) % lanes_.size()];
+            if (!lane.items.empty()) {
+                return lane.items.front();
+            }
+        }
+    }
+
+    // Append a copy of every queued item to out, lane by lane and oldest
+    // first, leaving the queue as it is. Holds the lock while copying.
+    void copyItems(std::vector<T>& out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out.reserve(out.size() + size_);
+        for (const auto& lane : lanes_) {
+            for (size_t i = 0; i < lane->items.size(); ++i) {
+                out.push_back(lane->items[i]);
+            }
+        }
     }
 
     // Get queue size
     size_t size() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.size();
+        return size_;
     }
 
     // Check if queue is empty
     bool empty() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.empty();
+        return size_ == 0;
     }
 
-    // Check if queue is full
+    // Check if queue is full (every lane is)
     bool full() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return queue_.size() >= maxSize_;
+        return size_ >= maxSize_;
     }
 
     // Clear all items
     void clear() {
         std::lock_guard<std::mutex> lock(mutex_);
-        while (!queue_.empty()) {
-            queue_.pop_front();
+        for (auto& lane : lanes_) {
+            lane->items.clear();
+            lane->enqueuedAt.clear();
+            lane->deficit = 0;
+            lane->notFull.notify_all();
         }
-        notFull_.notify_all();
+        size_ = 0;
     }
 
     // Gracefully shutdown queue
     void shutdown() {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            shutdown_ = true;
-        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = true;
         notEmpty_.notify_all();
-        notFull_.notify_all();
+        for (auto& lane : lanes_) {
+            lane->notFull.notify_all();
+        }
+    }
+
+    // Accept items again after shutdown(). Items still queued are kept.
+    void reopen() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shutdown_ = false;
     }
 
     // Check if shutdown
@@ -125,19 +353,222 @@ public:
         size_t maxSize;
         bool isFull;
         bool isEmpty;
+        uint64_t totalEnqueued;
+        uint64_t totalDequeued;
+        std::vector<LaneStats> lanes;
     };
 
     Stats getStats() const {
         std::lock_guard<std::mutex> lock(mutex_);
-        return {queue_.size(), maxSize_, 
-                queue_.size() >= maxSize_, queue_.empty()};
+        Stats stats{size_, maxSize_, size_ >= maxSize_, size_ == 0,
+                    totalEnqueued_, totalDequeued_, {}};
+        for (const auto& lane : lanes_) {
+            LaneStats laneStats;
+            laneStats.depth = lane->items.size();
+            laneStats.capacity = lane->capacity;
+            laneStats.weight = lane->weight;
+            laneStats.totalEnqueued = lane->enqueued;
+            laneStats.totalDequeued = lane->dequeued;
+            if (lane->wait) {
+                laneStats.wait = lane->wait->snapshot();
+            }
+            stats.lanes.push_back(std::move(laneStats));
+        }
+        return stats;
     }
 
 private:
+    struct Lane {
+        Lane(const LaneConfig& config, bool timed)
+            : items(std::min(config.capacity, kPreallocatedSlots)),
+              capacity(config.capacity), weight(std::max(config.weight, 1u)),
+              wait(timed ? std::make_unique<LatencyHistogram>() : nullptr) {}
+
+        bool hasRoom() const {
+            return items.size() < capacity;
+        }
+
+        SlabRing<T> items;
+        SlabRing<int64_t> enqueuedAt; // Parallel to items; multi-lane only
+        size_t capacity;
+        unsigned weight;
+        unsigned deficit = 0;         // Items left in the current turn
+        uint64_t enqueued = 0;
+        uint64_t dequeued = 0;
+        std::condition_variable notFull;
+        std::unique_ptr<LatencyHistogram> wait; // Recorded under mutex_
+    };
+
+    template<typename... Args>
+    bool emplaceTo(size_t index, int timeoutMs, Args&&... args) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        Lane& lane = *lanes_[index];
+
+        if (timeoutMs > 0) {
+            if (!lane.notFull.wait_for(lock,
+                std::chrono::milliseconds(timeoutMs),
+                [&] { return lane.hasRoom() || shutdown_; })) {
+                return false; // Timeout
+            }
+        } else {
+            lane.notFull.wait(lock, [&] {
+                return lane.hasRoom() || shutdown_;
+            });
+        }
+
+        if (shutdown_) return false;
+
+        pushLocked(lane, timed_ ? monotonicNanos() : 0, std::forward<Args>(args)...);
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    template<typename InputIt>
+    size_t enqueueBulkTo(size_t index, InputIt first, InputIt last, int timeoutMs) {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 0);
+
+        size_t added = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        Lane& lane = *lanes_[index];
+        auto hasRoom = [&] { return lane.hasRoom() || shutdown_; };
+        while (first != last) {
+            if (timeoutMs > 0) {
+                if (!lane.notFull.wait_until(lock, deadline, hasRoom)) {
+                    break; // Timeout
+                }
+            } else {
+                lane.notFull.wait(lock, hasRoom);
+            }
+
+            if (shutdown_) break;
+
+            size_t pushed = pushRunLocked(lane, first, last);
+            added += pushed;
+            notifyConsumers(pushed);
+        }
+        return added;
+    }
+
+    template<typename... Args>
+    bool tryEmplaceTo(size_t index, Args&&... args) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Lane& lane = *lanes_[index];
+        if (shutdown_ || !lane.hasRoom()) {
+            return false;
+        }
+        pushLocked(lane, timed_ ? monotonicNanos() : 0, std::forward<Args>(args)...);
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    template<typename InputIt>
+    size_t tryEnqueueBulkTo(size_t index, InputIt first, InputIt last) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (shutdown_) return 0;
+        size_t pushed = pushRunLocked(*lanes_[index], first, last);
+        notifyConsumers(pushed);
+        return pushed;
+    }
+
+    // Oldest item of one lane, outside the round-robin
+    std::optional<T> tryDequeueFrom(size_t index) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Lane& lane = *lanes_[index];
+        if (lane.items.empty()) {
+            return std::nullopt;
+        }
+        T item = std::move(lane.items.front());
+        lane.items.pop_front();
+        if (timed_) {
+            lane.wait->record(waitedNs(lane.enqueuedAt.front(), monotonicNanos()));
+            lane.enqueuedAt.pop_front();
+        }
+        ++lane.dequeued;
+        --size_;
+        ++totalDequeued_;
+        lane.notFull.notify_one();
+        return item;
+    }
+
+    template<typename... Args>
+    void pushLocked(Lane& lane, int64_t now, Args&&... args) {
+        lane.items.emplace_back(std::forward<Args>(args)...);
+        if (timed_) {
+            lane.enqueuedAt.push_back(now);
+        }
+        ++lane.enqueued;
+        ++size_;
+        ++totalEnqueued_;
+    }
+
+    // Push from first while the lane has room; the run shares one stamp
+    template<typename InputIt>
+    size_t pushRunLocked(Lane& lane, InputIt& first, InputIt last) {
+        int64_t now = timed_ ? monotonicNanos() : 0;
+        size_t pushed = 0;
+        while (first != last && lane.hasRoom()) {
+            pushLocked(lane, now, *first);
+            ++first;
+            ++pushed;
+        }
+        return pushed;
+    }
+
+    // Deficit round-robin. A lane's turn starts with weight credits and
+    // every item costs one; the turn passes on when the credits run out
+    // or the lane empties, and an empty lane keeps no credit. Needs at
+    // least one item queued; from names the lane it came out of.
+    T popLocked(int64_t now, Lane*& from) {
+        Lane* lane = lanes_[current_].get();
+        while (lane->items.empty()) {
+            lane->deficit = 0;
+            current_ = (current_ + 1) % lanes_.size();
+            lane = lanes_[current_].get();
+        }
+        if (lane->deficit == 0) {
+            lane->deficit = lane->weight;
+        }
+
+        T item = std::move(lane->items.front());
+        lane->items.pop_front();
+        if (timed_) {
+            lane->wait->record(waitedNs(lane->enqueuedAt.front(), now));
+            lane->enqueuedAt.pop_front();
+        }
+        ++lane->dequeued;
+        --size_;
+        ++totalDequeued_;
+
+        if (--lane->deficit == 0 || lane->items.empty()) {
+            lane->deficit = 0;
+            current_ = (current_ + 1) % lanes_.size();
+        }
+        from = lane;
+        return item;
+    }
+
+    static uint64_t waitedNs(int64_t from, int64_t to) {
+        return to > from ? static_cast<uint64_t>(to - from) : 0;
+    }
+
+    void notifyConsumers(size_t pushed) {
+        if (pushed == 1) {
+            notEmpty_.notify_one();
+        } else if (pushed > 1) {
+            notEmpty_.notify_all();
+        }
+    }
+
     mutable std::mutex mutex_;
     std::condition_variable notEmpty_;
-    std::condition_variable notFull_;
-    std::deque<T> queue_;
-    size_t maxSize_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+    size_t maxSize_; // Sum of the lane capacities
+    // Only touched under mutex_, which every update already holds
+    size_t size_;    // Across all lanes
+    size_t current_; // Lane whose round-robin turn it is
+    bool timed_;     // More than one lane: stamp items to measure per-lane waits
     bool shutdown_;
+    uint64_t totalEnqueued_;
+    uint64_t totalDequeued_;
 };
@@ -0,0 +1,384 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI // wingdi.h defines ERROR, which breaks LOG_ERROR
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "ResultSink.h"
+#include "Logger.h"
+
+// Read-only mapping of a whole file. The kernel is told the file will be
+// read front to back, so it reads ahead aggressively.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    explicit MappedFile(const std::string& path) {
+        open(path);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path) {
+        close();
+#if defined(_WIN32)
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            LOG_ERROR("Cannot open " + path);
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size)) {
+            LOG_ERROR("Cannot stat " + path);
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ > 0) {
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            void* view = mapping_ ? MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) : nullptr;
+            if (!view) {
+                LOG_ERROR("Cannot map " + path);
+                close();
+                return false;
+            }
+            data_ = static_cast<const uint8_t*>(view);
+        }
+#else
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) {
+            LOG_ERROR("Cannot open " + path + ": " + std::strerror(errno));
+            return false;
+        }
+        struct stat info;
+        if (::fstat(fd_, &info) != 0) {
+            LOG_ERROR("Cannot stat " + path + ": " + std::strerror(errno));
+            close();
+            return false;
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        if (size_ > 0) {
+            void* view = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+            if (view == MAP_FAILED) {
+                LOG_ERROR("Cannot map " + path + ": " + std::strerror(errno));
+                close();
+                return false;
+            }
+            data_ = static_cast<const uint8_t*>(view);
+            ::madvise(view, size_, MADV_SEQUENTIAL);
+        }
+#endif
+        path_ = path;
+        open_ = true;
+        return true;
+    }
+
+    void close() {
+#if defined(_WIN32)
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+        mapping_ = nullptr;
+        file_ = INVALID_HANDLE_VALUE;
+#else
+        if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+        if (fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        data_ = nullptr;
+        size_ = 0;
+        released_ = 0;
+        open_ = false;
+    }
+
+    // Drop pages before offset from this process once they have been
+    // consumed; they stay in the page cache. Keeps resident memory flat
+    // while a multi-GB file streams through.
+    void release(size_t offset) {
+#if !defined(_WIN32)
+        auto page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+        size_t end = std::min(offset, size_) / page * page;
+        if (data_ && end > released_) {
+            ::madvise(const_cast<uint8_t*>(data_) + released_, end - released_, MADV_DONTNEED);
+            released_ = end;
+        }
+#else
+        (void)offset;
+#endif
+    }
+
+    bool isOpen() const {
+        return open_;
+    }
+
+    const uint8_t* data() const {
+        return data_;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    const std::string& path() const {
+        return path_;
+    }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    size_t released_ = 0;
+    bool open_ = false;
+    std::string path_;
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// Feeds a file of raw T samples (native byte order, no header) into a
+// ProcessingSystem or Pipeline. The file is mapped rather than read;
+// every chunk goes to addBatch() straight from the mapping, so input
+// runs at one queue operation per chunk instead of one per item.
+template<typename T>
+class FileSource {
+    static_assert(std::is_trivially_copyable<T>::value, "FileSource reads raw samples");
+
+public:
+    static constexpr size_t kDefaultChunkItems = 4096;
+
+    explicit FileSource(const std::string& path, size_t chunkItems = kDefaultChunkItems)
+        : file_(path), chunkItems_(std::max<size_t>(chunkItems, 1)) {
+        if (file_.size() % sizeof(T) != 0) {
+            LOG_WARNING(path + ": " + std::to_string(file_.size() % sizeof(T)) +
+                        " trailing bytes ignored");
+        }
+    }
+
+    bool isOpen() const {
+        return file_.isOpen();
+    }
+
+    size_t itemCount() const {
+        return file_.size() / sizeof(T);
+    }
+
+    // The mapped samples; mmap returns page-aligned memory, so the
+    // pointer is suitably aligned for T
+    const T* data() const {
+        return reinterpret_cast<const T*>(file_.data());
+    }
+
+    // Send every remaining item to system, chunk by chunk. Stops early if
+    // a chunk is not fully accepted within timeoutMs; feed() resumes from
+    // the first item that was not taken. Returns the items accepted.
+    template<typename System>
+    size_t feed(System& system, int timeoutMs = 1000) {
+        size_t count = itemCount();
+        size_t accepted = 0;
+        while (next_ < count) {
+            size_t n = std::min(chunkItems_, count - next_);
+            size_t added = system.addBatch(data() + next_, data() + next_ + n, timeoutMs);
+            next_ += added;
+            accepted += added;
+            file_.release(next_ * sizeof(T));
+            if (added < n) {
+                LOG_WARNING(file_.path() + ": input stalled after " + std::to_string(next_) + " items");
+                break;
+            }
+        }
+        return accepted;
+    }
+
+    // Items handed on so far
+    size_t position() const {
+        return next_;
+    }
+
+private:
+    MappedFile file_;
+    size_t chunkItems_;
+    size_t next_ = 0;
+};
+
+// Writes results as raw T samples to a file. Workers append into one
+// large buffer that goes out in a single write when full; batches bigger
+// than the buffer skip it and go out with the buffer in one writev().
+// Files are written in delivery order (input order with
+// setOrderedOutput()).
+template<typename T>
+class FileSink : public ResultSink<T> {
+    static_assert(std::is_trivially_copyable<T>::value, "FileSink writes raw samples");
+
+public:
+    static constexpr size_t kDefaultBufferBytes = 1 << 20;
+
+    explicit FileSink(const std::string& path, size_t bufferBytes = kDefaultBufferBytes)
+        : path_(path),
+          capacity_(std::max(bufferBytes / sizeof(T), size_t(1)) * sizeof(T)),
+          buffer_(new uint8_t[capacity_]) {
+#if defined(_WIN32)
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) {
+            LOG_ERROR("Cannot create " + path);
+        }
+#else
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            LOG_ERROR("Cannot create " + path + ": " + std::strerror(errno));
+        }
+#endif
+    }
+
+    ~FileSink() override {
+        close();
+    }
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    size_t deliver(std::vector<T>& results) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!isOpenLocked() || failed_) return 0;
+
+        size_t bytes = results.size() * sizeof(T);
+        const auto* source = reinterpret_cast<const uint8_t*>(results.data());
+        if (bytes >= capacity_) {
+            if (!writeLocked(buffer_.get(), used_, source, bytes)) return 0;
+            used_ = 0;
+        } else {
+            if (used_ + bytes > capacity_) {
+                if (!writeLocked(buffer_.get(), used_, nullptr, 0)) return 0;
+                used_ = 0;
+            }
+            std::memcpy(buffer_.get() + used_, source, bytes);
+            used_ += bytes;
+        }
+        written_ += results.size();
+        return results.size();
+    }
+
+    // Write out what is buffered
+    bool flush() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!isOpenLocked()) return false;
+        if (used_ > 0 && !writeLocked(buffer_.get(), used_, nullptr, 0)) return false;
+        used_ = 0;
+        return !failed_;
+    }
+
+    // Flush and close; later deliveries are refused
+    bool close() {
+        bool ok = flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+#if defined(_WIN32)
+        if (file_) ok = std::fclose(file_) == 0 && ok;
+        file_ = nullptr;
+#else
+        if (fd_ >= 0) ok = ::close(fd_) == 0 && ok;
+        fd_ = -1;
+#endif
+        return ok;
+    }
+
+    // Items accepted so far (buffered or written)
+    uint64_t itemsWritten() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return written_;
+    }
+
+private:
+    bool isOpenLocked() const {
+#if defined(_WIN32)
+        return file_ != nullptr;
+#else
+        return fd_ >= 0;
+#endif
+    }
+
+    // Write first then second, retrying short writes
+    bool writeLocked(const uint8_t* first, size_t firstBytes,
+                     const uint8_t* second, size_t secondBytes) {
+#if defined(_WIN32)
+        bool ok = std::fwrite(first, 1, firstBytes, file_) == firstBytes &&
+                  std::fwrite(second, 1, secondBytes, file_) == secondBytes;
+#else
+        iovec parts[2] = {{const_cast<uint8_t*>(first), firstBytes},
+                          {const_cast<uint8_t*>(second), secondBytes}};
+        int index = 0;
+        bool ok = true;
+        while (index < 2) {
+            if (parts[index].iov_len == 0) {
+                ++index;
+                continue;
+            }
+            ssize_t n = ::writev(fd_, parts + index, 2 - index);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                ok = false;
+                break;
+            }
+            auto done = static_cast<size_t>(n);
+            while (index < 2 && done >= parts[index].iov_len) {
+                done -= parts[index].iov_len;
+                ++index;
+            }
+            if (index < 2) {
+                parts[index].iov_base = static_cast<uint8_t*>(parts[index].iov_base) + done;
+                parts[index].iov_len -= done;
+            }
+        }
+#endif
+        if (!ok) {
+            LOG_ERROR("Write to " + path_ + " failed");
+            failed_ = true;
+        }
+        return ok;
+    }
+
+    std::string path_;
+    size_t capacity_;
+    std::unique_ptr<uint8_t[]> buffer_;
+    size_t used_ = 0;
+    uint64_t written_ = 0;
+    bool failed_ = false;
+    mutable std::mutex mutex_;
+#if defined(_WIN32)
+    std::FILE* file_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
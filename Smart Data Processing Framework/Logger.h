@@ -2,12 +2,29 @@
 
 #include <iostream>
 #include <fstream>
-#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
 #include <mutex>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
+#include <cstdio>
 #include <ctime>
 
+#include "RingBufferQueue.h"
+
+// Compile-time minimum log level: 0 = DEBUG, 1 = INFO, 2 = WARNING,
+// 3 = ERROR, 4 = CRITICAL. Statements below it compile out entirely.
+// Defaults to dropping DEBUG in release (NDEBUG) builds.
+#ifndef SDPF_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define SDPF_LOG_MIN_LEVEL 1
+#else
+#define SDPF_LOG_MIN_LEVEL 0
+#endif
+#endif
+
 // Safe localtime wrapper for Windows and Linux
 inline std::tm safe_localtime(std::time_t time) {
     std::tm tm_buf = {};
@@ -28,59 +45,207 @@ class Logger {
 public:
     enum class Level { DEBUG, INFO, WARNING, ERROR, CRITICAL };
 
+    // What async producers do when the record ring is full
+    enum class OverflowPolicy { BLOCK, DROP };
+
     static Logger& getInstance() {
         static Logger instance;
         return instance;
     }
 
     void setLogLevel(Level level) {
-        level_ = level;
+        level_.store(level, std::memory_order_relaxed);
+    }
+
+    // Cheap check used by the LOG_* macros before building a message
+    bool isEnabled(Level level) const {
+        return level >= level_.load(std::memory_order_relaxed);
     }
 
     template<typename... Args>
     void log(Level level, const std::string& message, Args&&... args) {
-        if (level < level_) return;
+        if (!isEnabled(level)) return;
 
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::string line = formatLine(level, message);
+        if (logAsync(line)) return;
 
-        auto now = std::chrono::system_clock::now();
-        auto time = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
+        std::lock_guard<std::mutex> lock(mutex_);
+        line += '\n';
+        std::cout << line << std::flush;
 
-        std::stringstream ss;
+        if (logFile_.is_open()) {
+            logFile_ << line;
+            logFile_.flush();
+        }
+    }
 
-        // Use safe_localtime instead of localtime - NO WARNING!
-        auto tm_time = safe_localtime(time);
+    // Switch to asynchronous logging: producers only format and enqueue a
+    // record, and one writer thread batches the writes to stdout and the
+    // log file, flushing at least every flushInterval
+    void enableAsync(size_t capacity = 8192,
+                     std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100),
+                     OverflowPolicy policy = OverflowPolicy::BLOCK) {
+        std::lock_guard<std::mutex> lock(asyncControlMutex_);
+        if (std::atomic_load(&asyncQueue_)) return;
 
-        ss << std::put_time(&tm_time, "[%H:%M:%S")
-            << "." << std::setfill('0') << std::setw(3) << ms.count() << "] ";
-        ss << "[" << levelToString(level) << "] ";
-        ss << message;
+        overflowPolicy_ = policy;
+        auto queue = std::make_shared<RingBufferQueue<std::string>>(capacity);
+        writer_ = std::thread(&Logger::writerLoop, this, queue, flushInterval);
+        std::atomic_store(&asyncQueue_, queue);
+    }
 
-        std::cout << ss.str() << std::endl;
+    // Return to synchronous logging. Every record accepted so far is
+    // written and flushed before this returns.
+    void disableAsync() {
+        std::lock_guard<std::mutex> lock(asyncControlMutex_);
+        auto queue = std::atomic_load(&asyncQueue_);
+        if (!queue) return;
 
-        if (logFile_.is_open()) {
-            logFile_ << ss.str() << std::endl;
-            logFile_.flush();
+        std::atomic_store(&asyncQueue_, std::shared_ptr<RingBufferQueue<std::string>>());
+        // Producers that still saw the queue finish their enqueue first;
+        // the writer keeps draining, so blocked ones get through
+        while (asyncProducers_.load() != 0) {
+            std::this_thread::yield();
+        }
+        queue->shutdown();
+        if (writer_.joinable()) {
+            writer_.join();
         }
     }
 
+    bool isAsync() const {
+        return std::atomic_load(&asyncQueue_) != nullptr;
+    }
+
+    // Records discarded under OverflowPolicy::DROP
+    size_t droppedMessages() const {
+        return droppedMessages_.load(std::memory_order_relaxed);
+    }
+
 private:
-    Logger() : level_(Level::INFO) {
+    Logger() : level_(Level::INFO), overflowPolicy_(OverflowPolicy::BLOCK),
+               droppedMessages_(0), asyncProducers_(0) {
         logFile_.open("processing_framework.log", std::ios::app);
     }
 
     ~Logger() {
+        disableAsync();
         if (logFile_.is_open()) {
             logFile_.close();
         }
     }
 
+    // Counts a producer for as long as it may hold the async queue
+    struct ProducerScope {
+        explicit ProducerScope(std::atomic<size_t>& count) : count_(count) {
+            count_.fetch_add(1);
+        }
+        ~ProducerScope() {
+            count_.fetch_sub(1);
+        }
+        std::atomic<size_t>& count_;
+    };
+
+    // Hand the record to the writer thread. False when async mode is off
+    // and the caller has to write it.
+    bool logAsync(const std::string& line) {
+        // Registered before the queue is read: disableAsync() either sees
+        // this producer and waits for it, or this producer sees no queue
+        ProducerScope scope(asyncProducers_);
+        auto queue = std::atomic_load(&asyncQueue_);
+        if (!queue) return false;
+
+        bool queued = overflowPolicy_ == OverflowPolicy::DROP
+            ? queue->tryEnqueue(line)
+            : queue->enqueue(line);
+        if (!queued) {
+            droppedMessages_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    static std::string formatLine(Level level, const std::string& message) {
+        auto now = std::chrono::system_clock::now();
+        auto time = std::chrono::system_clock::to_time_t(now);
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            now.time_since_epoch()) % 1000;
+
+        // localtime is comparatively slow, so reuse the formatted clock
+        // until the second changes
+        thread_local std::time_t cachedTime = -1;
+        thread_local char clock[16] = {};
+        if (time != cachedTime) {
+            auto tm_time = safe_localtime(time);
+            std::strftime(clock, sizeof(clock), "%H:%M:%S", &tm_time);
+            cachedTime = time;
+        }
+
+        char prefix[32];
+        std::snprintf(prefix, sizeof(prefix), "[%s.%03d] [",
+                      clock, static_cast<int>(ms.count()));
+
+        std::string line;
+        line.reserve(message.size() + 32);
+        line += prefix;
+        line += levelToString(level);
+        line += "] ";
+        line += message;
+        return line;
+    }
+
+    void writerLoop(std::shared_ptr<RingBufferQueue<std::string>> queue,
+                    std::chrono::milliseconds flushInterval) {
+        constexpr size_t kMaxBatch = 256;
+        int waitMs = flushInterval.count() > 0 ? static_cast<int>(flushInterval.count()) : 1;
+
+        std::vector<std::string> records;
+        std::string buffer;
+        records.reserve(kMaxBatch);
+        auto lastFlush = std::chrono::steady_clock::now();
+
+        for (;;) {
+            records.clear();
+            size_t count = queue->dequeueBulk(records, kMaxBatch, waitMs);
+            if (count == 0 && queue->isShutdown() && queue->empty()) {
+                break;
+            }
+
+            if (count > 0) {
+                buffer.clear();
+                for (const auto& record : records) {
+                    buffer += record;
+                    buffer += '\n';
+                }
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::cout.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                if (logFile_.is_open()) {
+                    logFile_.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                }
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - lastFlush >= flushInterval) {
+                flushOutputs();
+                lastFlush = now;
+            }
+        }
+
+        flushOutputs();
+    }
+
+    void flushOutputs() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::cout.flush();
+        if (logFile_.is_open()) {
+            logFile_.flush();
+        }
+    }
+
     Logger(const Logger&) = delete;
     Logger& operator=(const Logger&) = delete;
 
-    static std::string levelToString(Level level) {
+    static const char* levelToString(Level level) {
         switch (level) {
         case Level::DEBUG: return "DEBUG";
         case Level::INFO: return "INFO";
@@ -91,13 +256,57 @@ private:
         }
     }
 
-    Level level_;
+    std::atomic<Level> level_;
     std::mutex mutex_;
     std::ofstream logFile_;
+
+    // Non-null while async mode is on; published/read like a snapshot
+    std::shared_ptr<RingBufferQueue<std::string>> asyncQueue_;
+    std::mutex asyncControlMutex_;
+    std::thread writer_;
+    OverflowPolicy overflowPolicy_;
+    std::atomic<size_t> droppedMessages_;
+    std::atomic<size_t> asyncProducers_; // Inside logAsync()
 };
 
-#define LOG_DEBUG(msg) Logger::getInstance().log(Logger::Level::DEBUG, msg)
-#define LOG_INFO(msg) Logger::getInstance().log(Logger::Level::INFO, msg)
-#define LOG_WARNING(msg) Logger::getInstance().log(Logger::Level::WARNING, msg)
-#define LOG_ERROR(msg) Logger::getInstance().log(Logger::Level::ERROR, msg)
-#define LOG_CRITICAL(msg) Logger::getInstance().log(Logger::Level::CRITICAL, msg)
+// The level is checked before msg is evaluated, so disabled statements
+// never build their message
+#define SDPF_LOG(level, msg) \
+    do { \
+        if (Logger::getInstance().isEnabled(level)) { \
+            Logger::getInstance().log(level, msg); \
+        } \
+    } while (0)
+
+// Compiled-out statement: msg stays type-checked but is never evaluated
+#define SDPF_LOG_DISCARD(msg) do { (void)sizeof(msg); } while (0)
+
+#if SDPF_LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(msg) SDPF_LOG(Logger::Level::DEBUG, msg)
+#else
+#define LOG_DEBUG(msg) SDPF_LOG_DISCARD(msg)
+#endif
+
+#if SDPF_LOG_MIN_LEVEL <= 1
+#define LOG_INFO(msg) SDPF_LOG(Logger::Level::INFO, msg)
+#else
+#define LOG_INFO(msg) SDPF_LOG_DISCARD(msg)
+#endif
+
+#if SDPF_LOG_MIN_LEVEL <= 2
+#define LOG_WARNING(msg) SDPF_LOG(Logger::Level::WARNING, msg)
+#else
+#define LOG_WARNING(msg) SDPF_LOG_DISCARD(msg)
+#endif
+
+#if SDPF_LOG_MIN_LEVEL <= 3
+#define LOG_ERROR(msg) SDPF_LOG(Logger::Level::ERROR, msg)
+#else
+#define LOG_ERROR(msg) SDPF_LOG_DISCARD(msg)
+#endif
+
+#if SDPF_LOG_MIN_LEVEL <= 4
+#define LOG_CRITICAL(msg) SDPF_LOG(Logger::Level::CRITICAL, msg)
+#else
+#define LOG_CRITICAL(msg) SDPF_LOG_DISCARD(msg)
+#endif
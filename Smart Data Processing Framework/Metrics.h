@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "CacheLine.h"
+
+// Monotonic timestamp in nanoseconds, used to stamp items as they enter
+// a ProcessingSystem
+inline int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Index of the highest set bit; value must be non-zero
+inline int highestBit(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) ++bit;
+    return bit;
+#endif
+}
+
+// Counter with a single writing thread. Increments are a plain load and
+// store, so they cost no more than a non-atomic add, yet other threads
+// can read the value at any time.
+class SingleWriterCounter {
+public:
+    void add(uint64_t n = 1) {
+        value_.store(value_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    uint64_t load() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// HDR-style log-linear latency histogram: every power of two is split into
+// 16 linear sub-buckets, giving ~6% relative precision from 1 ns to hours
+// in a fixed 976-bucket table. Recording is single-writer (one histogram
+// per worker); snapshot() may be called from any thread and snapshots of
+// different histograms can be merged.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr uint64_t kSubBucketCount = uint64_t(1) << kSubBucketBits;
+    static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) << kSubBucketBits;
+
+    // Record a value (in nanoseconds) count times
+    void record(uint64_t valueNs, uint64_t count = 1) {
+        if (count == 0) return;
+        auto& bucket = counts_[bucketFor(valueNs)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        total_.add(count);
+        sum_.add(valueNs * count);
+        if (valueNs > max_.load(std::memory_order_relaxed)) {
+            max_.store(valueNs, std::memory_order_relaxed);
+        }
+    }
+
+    class Snapshot {
+    public:
+        Snapshot() : counts_(kBucketCount, 0), total_(0), sum_(0), max_(0) {}
+
+        uint64_t count() const { return total_; }
+        uint64_t maxNs() const { return max_; }
+
+        double meanNs() const {
+            return total_ ? static_cast<double>(sum_) / static_cast<double>(total_) : 0.0;
+        }
+
+        // Value at quantile q (0..1), reported as the bucket's upper bound
+        // so percentiles never under-state latency
+        uint64_t percentileNs(double q) const {
+            if (total_ == 0) return 0;
+            auto target = static_cast<uint64_t>(q * static_cast<double>(total_));
+            if (target < 1) target = 1;
+            uint64_t seen = 0;
+            for (size_t i = 0; i < counts_.size(); ++i) {
+                seen += counts_[i];
+                if (seen >= target) {
+                    uint64_t upper = bucketUpperBound(i);
+                    return upper < max_ ? upper : max_;
+                }
+            }
+            return max_;
+        }
+
+        void merge(const Snapshot& other) {
+            for (size_t i = 0; i < counts_.size(); ++i) {
+                counts_[i] += other.counts_[i];
+            }
+            total_ += other.total_;
+            sum_ += other.sum_;
+            if (other.max_ > max_) max_ = other.max_;
+        }
+
+    private:
+        friend class LatencyHistogram;
+
+        std::vector<uint64_t> counts_;
+        uint64_t total_;
+        uint64_t sum_;
+        uint64_t max_;
+    };
+
+    Snapshot snapshot() const {
+        Snapshot snap;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            snap.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+            snap.total_ += snap.counts_[i];
+        }
+        snap.sum_ = sum_.load();
+        snap.max_ = max_.load(std::memory_order_relaxed);
+        return snap;
+    }
+
+private:
+    // Values below 16 get exact buckets; above that the top 5 significant
+    // bits select the bucket
+    static size_t bucketFor(uint64_t value) {
+        if (value < kSubBucketCount) {
+            return static_cast<size_t>(value);
+        }
+        int shift = highestBit(value) - kSubBucketBits;
+        uint64_t sub = (value >> shift) & (kSubBucketCount - 1);
+        return (static_cast<size_t>(shift + 1) << kSubBucketBits) + static_cast<size_t>(sub);
+    }
+
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < kSubBucketCount) {
+            return index;
+        }
+        int shift = static_cast<int>(index >> kSubBucketBits) - 1;
+        uint64_t sub = index & (kSubBucketCount - 1);
+        uint64_t lower = (kSubBucketCount + sub) << shift;
+        return lower + ((uint64_t(1) << shift) - 1);
+    }
+
+    std::array<std::atomic<uint64_t>, kBucketCount> counts_{};
+    SingleWriterCounter total_;
+    SingleWriterCounter sum_;
+    std::atomic<uint64_t> max_{0};
+};
+
+// Everything one worker records, padded so that neighbouring workers
+// never share a cache line. Only the owning worker writes.
+struct alignas(kCacheLineSize) WorkerMetrics {
+    LatencyHistogram queueWait;  // addData() until a worker picks the item up
+    LatencyHistogram processing; // Per-item share of its batch's process time
+    LatencyHistogram outputWait; // Per-batch time spent handing results on
+    LatencyHistogram endToEnd;   // addData() until the result is delivered
+
+    SingleWriterCounter itemsProcessed;
+    SingleWriterCounter itemsFiltered; // Dropped by the processor on purpose
+    SingleWriterCounter batches;
+    SingleWriterCounter busyNs;
+    SingleWriterCounter idleNs;
+    SingleWriterCounter lockContentions;
+    SingleWriterCounter outputTimeouts;
+};
+
+// Point-in-time copy of one worker's metrics
+struct WorkerMetricsSnapshot {
+    size_t workerId = 0;
+    uint64_t itemsProcessed = 0;
+    uint64_t itemsFiltered = 0;
+    uint64_t batches = 0;
+    uint64_t busyNs = 0;
+    uint64_t idleNs = 0;
+    uint64_t lockContentions = 0;
+    uint64_t outputTimeouts = 0;
+    LatencyHistogram::Snapshot queueWait;
+    LatencyHistogram::Snapshot processing;
+    LatencyHistogram::Snapshot outputWait;
+    LatencyHistogram::Snapshot endToEnd;
+
+    // Fraction of the worker's lifetime spent on batches
+    double utilization() const {
+        uint64_t total = busyNs + idleNs;
+        return total ? static_cast<double>(busyNs) / static_cast<double>(total) : 0.0;
+    }
+};
+
+// Point-in-time copy of a whole system's metrics. Histograms are the
+// merge of all workers; counters are cumulative since construction, so
+// periodic scrapers diff consecutive snapshots.
+struct SystemMetrics {
+    std::chrono::steady_clock::time_point takenAt;
+    LatencyHistogram::Snapshot queueWait;
+    LatencyHistogram::Snapshot processing;
+    LatencyHistogram::Snapshot outputWait;
+    LatencyHistogram::Snapshot endToEnd;
+    uint64_t inputTimeouts = 0;   // addData()/addBatch() items rejected on timeout
+    uint64_t inputShed = 0;       // Items dropped by the backpressure policy
+    uint64_t callerRuns = 0;      // Items processed on producer threads (CALLER_RUNS)
+    size_t activeWorkers = 0;
+    uint64_t outputTimeouts = 0;  // Results dropped because delivery timed out
+    uint64_t lockContentions = 0; // Serial-processor lock found already held
+    std::vector<WorkerMetricsSnapshot> workers;
+};
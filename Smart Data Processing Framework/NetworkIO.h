@@ -0,0 +1,717 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <type_traits>
+#include <climits>
+#include <cstring>
+#include <cstdint>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI // wingdi.h defines ERROR, which breaks LOG_ERROR
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include "ProcessingSystem.h"
+#include "ResultSink.h"
+#include "Checkpoint.h"
+#include "Logger.h"
+
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+constexpr NativeSocket kInvalidSocket = INVALID_SOCKET;
+#else
+using NativeSocket = int;
+constexpr NativeSocket kInvalidSocket = -1;
+#endif
+
+inline std::string socketError() {
+#if defined(_WIN32)
+    return "error " + std::to_string(WSAGetLastError());
+#else
+    return std::strerror(errno);
+#endif
+}
+
+// Winsock has to be started once per process before any socket call
+inline bool initSockets() {
+#if defined(_WIN32)
+    static const bool ready = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return ready;
+#else
+    return true;
+#endif
+}
+
+// Connected TCP stream. Nagle is off: frames are already batches, and a
+// credit frame held back waiting for more data stalls the sender.
+class TcpConnection {
+public:
+    TcpConnection() = default;
+
+    explicit TcpConnection(NativeSocket socket) : socket_(socket) {
+        if (socket_ == kInvalidSocket) return;
+        int on = 1;
+        ::setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+#if defined(SO_NOSIGPIPE)
+        ::setsockopt(socket_, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    }
+
+    ~TcpConnection() {
+        close();
+    }
+
+    TcpConnection(TcpConnection&& other) noexcept : socket_(other.socket_) {
+        other.socket_ = kInvalidSocket;
+    }
+
+    TcpConnection& operator=(TcpConnection&& other) noexcept {
+        if (this != &other) {
+            close();
+            socket_ = other.socket_;
+            other.socket_ = kInvalidSocket;
+        }
+        return *this;
+    }
+
+    TcpConnection(const TcpConnection&) = delete;
+    TcpConnection& operator=(const TcpConnection&) = delete;
+
+    static TcpConnection connect(const std::string& host, uint16_t port) {
+        if (!initSockets()) {
+            LOG_ERROR("Socket library unavailable");
+            return TcpConnection();
+        }
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* addresses = nullptr;
+        int status = ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+        if (status != 0) {
+            LOG_ERROR("Cannot resolve " + host + ": " + gai_strerror(status));
+            return TcpConnection();
+        }
+        NativeSocket socket = kInvalidSocket;
+        for (addrinfo* address = addresses; address; address = address->ai_next) {
+            socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (socket == kInvalidSocket) continue;
+            if (::connect(socket, address->ai_addr, static_cast<socklen_t>(address->ai_addrlen)) == 0) break;
+            closeSocket(socket);
+            socket = kInvalidSocket;
+        }
+        ::freeaddrinfo(addresses);
+        if (socket == kInvalidSocket) {
+            LOG_ERROR("Cannot connect to " + host + ":" + std::to_string(port) + ": " + socketError());
+        }
+        return TcpConnection(socket);
+    }
+
+    bool isOpen() const {
+        return socket_ != kInvalidSocket;
+    }
+
+    bool sendAll(const void* data, size_t n) {
+        const char* bytes = static_cast<const char*>(data);
+        while (n > 0) {
+            int chunk = static_cast<int>(std::min<size_t>(n, INT_MAX));
+            auto sent = ::send(socket_, bytes, chunk, kSendFlags);
+            if (sent < 0 && interrupted()) continue;
+            if (sent <= 0) return false;
+            bytes += sent;
+            n -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // False when the peer closes before n bytes arrive
+    bool receiveAll(void* data, size_t n) {
+        char* bytes = static_cast<char*>(data);
+        while (n > 0) {
+            int chunk = static_cast<int>(std::min<size_t>(n, INT_MAX));
+            auto received = ::recv(socket_, bytes, chunk, 0);
+            if (received < 0 && interrupted()) continue;
+            if (received <= 0) return false;
+            bytes += received;
+            n -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+    // Fail pending and later sends and receives, including ones blocked
+    // in another thread; the socket stays allocated until close()
+    void shutdown() {
+        if (!isOpen()) return;
+#if defined(_WIN32)
+        ::shutdown(socket_, SD_BOTH);
+#else
+        ::shutdown(socket_, SHUT_RDWR);
+#endif
+    }
+
+    void close() {
+        if (!isOpen()) return;
+        closeSocket(socket_);
+        socket_ = kInvalidSocket;
+    }
+
+private:
+    friend class TcpListener;
+
+#if defined(MSG_NOSIGNAL)
+    static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    static constexpr int kSendFlags = 0;
+#endif
+
+    static void closeSocket(NativeSocket socket) {
+#if defined(_WIN32)
+        ::closesocket(socket);
+#else
+        ::close(socket);
+#endif
+    }
+
+    static bool interrupted() {
+#if defined(_WIN32)
+        return false;
+#else
+        return errno == EINTR;
+#endif
+    }
+
+    NativeSocket socket_ = kInvalidSocket;
+};
+
+// Listening TCP socket on all IPv4 interfaces
+class TcpListener {
+public:
+    TcpListener() = default;
+
+    ~TcpListener() {
+        close();
+    }
+
+    TcpListener(const TcpListener&) = delete;
+    TcpListener& operator=(const TcpListener&) = delete;
+
+    // Port 0 picks a free port; port() tells which
+    bool listen(uint16_t port, int backlog = 16) {
+        close();
+        if (!initSockets()) {
+            LOG_ERROR("Socket library unavailable");
+            return false;
+        }
+        socket_ = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (socket_ == kInvalidSocket) {
+            LOG_ERROR("Cannot create socket: " + socketError());
+            return false;
+        }
+        int on = 1;
+        ::setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(socket_, backlog) != 0) {
+            LOG_ERROR("Cannot listen on port " + std::to_string(port) + ": " + socketError());
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    uint16_t port() const {
+        sockaddr_in address{};
+        socklen_t length = sizeof(address);
+        if (socket_ == kInvalidSocket ||
+            ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+            return 0;
+        }
+        return ntohs(address.sin_port);
+    }
+
+    // Blocks for the next connection; an unopened one once close() is called
+    TcpConnection accept() {
+        while (socket_ != kInvalidSocket) {
+            NativeSocket socket = ::accept(socket_, nullptr, nullptr);
+            if (socket != kInvalidSocket) return TcpConnection(socket);
+            if (!TcpConnection::interrupted()) break;
+        }
+        return TcpConnection();
+    }
+
+    // Safe to call while another thread is blocked in accept()
+    void close() {
+        NativeSocket socket = socket_;
+        if (socket == kInvalidSocket) return;
+        socket_ = kInvalidSocket;
+#if defined(_WIN32)
+        ::closesocket(socket);
+#else
+        ::shutdown(socket, SHUT_RDWR);
+        ::close(socket);
+#endif
+    }
+
+private:
+    std::atomic<NativeSocket> socket_{kInvalidSocket};
+};
+
+// Every message is one frame:
+//
+//   u32 length of what follows (little-endian) | u8 type | body
+//
+//   BATCH   u8 keyed | [varint key] | varint count | count items (Codec<T>)
+//   CREDIT  varint number of further items the receiver will take
+//
+// A receiver grants a window of items when a connection opens and gives
+// credit back as received items enter its system, so a sender never has
+// more than the window in flight and a slow node slows its senders down
+// instead of buffering without bound. Items use Codec<T>, so like
+// checkpoints and FileSource input they travel in native layout: nodes
+// must run the same build on the same kind of machine.
+enum class FrameType : uint8_t {
+    BATCH = 1,
+    CREDIT = 2
+};
+
+constexpr size_t kFrameHeaderBytes = 5;
+constexpr size_t kMaxFrameBytes = size_t(64) << 20;
+
+// Start a frame in out; the header is filled in by sendFrame
+inline void beginFrame(ByteWriter& out, FrameType type) {
+    const uint8_t header[kFrameHeaderBytes] = {0, 0, 0, 0, static_cast<uint8_t>(type)};
+    out.bytes().assign(header, header + kFrameHeaderBytes);
+}
+
+inline bool sendFrame(TcpConnection& connection, ByteWriter& frame) {
+    auto& bytes = frame.bytes();
+    if (bytes.size() < kFrameHeaderBytes || bytes.size() - 4 > kMaxFrameBytes) {
+        LOG_ERROR("Frame of " + std::to_string(bytes.size()) + " bytes is too large to send");
+        return false;
+    }
+    uint32_t length = static_cast<uint32_t>(bytes.size() - 4);
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<uint8_t>(length >> (8 * i));
+    }
+    return connection.sendAll(bytes.data(), bytes.size());
+}
+
+// Read one frame; body is left holding what follows the type byte
+inline bool receiveFrame(TcpConnection& connection, FrameType& type, std::vector<uint8_t>& body) {
+    uint8_t header[kFrameHeaderBytes];
+    if (!connection.receiveAll(header, sizeof(header))) return false;
+    uint32_t length = 0;
+    for (int i = 0; i < 4; ++i) {
+        length |= static_cast<uint32_t>(header[i]) << (8 * i);
+    }
+    if (length < 1 || length > kMaxFrameBytes) {
+        LOG_ERROR("Bad frame length " + std::to_string(length));
+        return false;
+    }
+    type = static_cast<FrameType>(header[4]);
+    body.resize(length - 1);
+    return body.empty() || connection.receiveAll(body.data(), body.size());
+}
+
+inline bool sendCredit(TcpConnection& connection, ByteWriter& frame, uint64_t items) {
+    beginFrame(frame, FrameType::CREDIT);
+    frame.writeVarint(items);
+    return sendFrame(connection, frame);
+}
+
+// Ingress of a node: accepts connections from NetworkSinks on other nodes
+// and adds the batches they send to a ProcessingSystem, a whole batch at
+// a time through addBatch. Keyed batches go in with their key when the
+// system runs SchedulingMode::PARTITIONED, so a key keeps its single
+// owner across nodes; otherwise the key is dropped. Every connection has
+// its own reader thread.
+template<typename T, template<typename> class QueueT = DataQueue>
+class NetworkSource {
+public:
+    static constexpr size_t kDefaultCreditWindow = 16384;
+
+    explicit NetworkSource(ProcessingSystem<T, QueueT>& system,
+                           size_t creditWindow = kDefaultCreditWindow)
+        : system_(system), creditWindow_(std::max<size_t>(creditWindow, 1)) {}
+
+    ~NetworkSource() {
+        stop();
+    }
+
+    NetworkSource(const NetworkSource&) = delete;
+    NetworkSource& operator=(const NetworkSource&) = delete;
+
+    bool start(uint16_t port) {
+        if (running_) {
+            LOG_WARNING("Network source already running");
+            return false;
+        }
+        if (!listener_.listen(port)) return false;
+        running_ = true;
+        acceptor_ = std::thread(&NetworkSource::acceptLoop, this);
+        LOG_INFO("Network source listening on port " + std::to_string(listener_.port()));
+        return true;
+    }
+
+    // Close the listener and every connection. Items of a batch that were
+    // not yet in the system are dropped, and their sender sees the
+    // connection fail.
+    void stop() {
+        if (!running_.exchange(false)) return;
+        listener_.close();
+        if (acceptor_.joinable()) acceptor_.join();
+        std::lock_guard<std::mutex> lock(connectionsMutex_);
+        for (auto& connection : connections_) {
+            connection->socket.shutdown();
+        }
+        for (auto& connection : connections_) {
+            if (connection->reader.joinable()) connection->reader.join();
+        }
+        connections_.clear();
+    }
+
+    uint16_t port() const {
+        return listener_.port();
+    }
+
+    uint64_t itemsReceived() const {
+        return itemsReceived_.load();
+    }
+
+    uint64_t batchesReceived() const {
+        return batchesReceived_.load();
+    }
+
+private:
+    // How long one addBatch call waits for room before checking whether
+    // the source is still running
+    static constexpr int kOfferTimeoutMs = 100;
+
+    struct Connection {
+        TcpConnection socket;
+        std::thread reader;
+        std::atomic<bool> finished{false};
+    };
+
+    void acceptLoop() {
+        while (running_) {
+            TcpConnection socket = listener_.accept();
+            if (!socket.isOpen()) {
+                if (running_) LOG_ERROR("Accept failed: " + socketError());
+                break;
+            }
+            std::lock_guard<std::mutex> lock(connectionsMutex_);
+            reapFinishedLocked();
+            connections_.push_back(std::make_unique<Connection>());
+            Connection& connection = *connections_.back();
+            connection.socket = std::move(socket);
+            connection.reader = std::thread(&NetworkSource::serve, this, std::ref(connection));
+        }
+    }
+
+    void reapFinishedLocked() {
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            if ((*it)->finished) {
+                (*it)->reader.join();
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void serve(Connection& connection) {
+        ByteWriter frame;
+        std::vector<uint8_t> body;
+        std::vector<T> items;
+        uint64_t outstanding = creditWindow_;
+
+        bool ok = sendCredit(connection.socket, frame, creditWindow_);
+        FrameType type;
+        while (ok && running_ && receiveFrame(connection.socket, type, body)) {
+            if (type != FrameType::BATCH) {
+                LOG_ERROR("Unexpected frame type " + std::to_string(static_cast<int>(type)));
+                break;
+            }
+            bool keyed = false;
+            uint64_t key = 0;
+            if (!decodeBatch(body, keyed, key, items)) {
+                LOG_ERROR("Malformed batch frame");
+                break;
+            }
+            if (items.size() > outstanding) {
+                LOG_ERROR("Sender exceeded its credit of " + std::to_string(outstanding) + " items");
+                break;
+            }
+            outstanding -= items.size();
+
+            size_t added = offer(keyed, key, items);
+            itemsReceived_ += added;
+            ++batchesReceived_;
+            if (added < items.size()) break;
+
+            outstanding += items.size();
+            ok = sendCredit(connection.socket, frame, items.size());
+        }
+        connection.socket.shutdown();
+        connection.finished = true;
+    }
+
+    bool decodeBatch(const std::vector<uint8_t>& body, bool& keyed, uint64_t& key, std::vector<T>& items) {
+        ByteReader in(body);
+        uint8_t flag = 0;
+        uint64_t count = 0;
+        if (!in.read(flag) || flag > 1) return false;
+        keyed = flag != 0;
+        if (keyed && !in.readVarint(key)) return false;
+        if (!in.readCount(count, std::is_trivially_copyable<T>::value ? sizeof(T) : 1)) return false;
+
+        items.resize(static_cast<size_t>(count));
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            if (!in.readBytes(items.data(), items.size() * sizeof(T))) return false;
+        } else {
+            for (auto& item : items) {
+                if (!in.read(item)) return false;
+            }
+        }
+        return in.atEnd();
+    }
+
+    // Add all of items, waiting for queue room as long as it takes
+    size_t offer(bool keyed, uint64_t key, std::vector<T>& items) {
+        bool partitioned = keyed && system_.getSchedulingMode() == SchedulingMode::PARTITIONED;
+        size_t added = 0;
+        while (added < items.size() && running_) {
+            if (!system_.isRunning()) {
+                LOG_WARNING("Network source dropping input: system is not running");
+                break;
+            }
+            auto first = std::make_move_iterator(items.begin() + added);
+            auto last = std::make_move_iterator(items.end());
+            added += partitioned ? system_.addBatch(PartitionKey(key), first, last, kOfferTimeoutMs)
+                                 : system_.addBatch(first, last, kOfferTimeoutMs);
+        }
+        return added;
+    }
+
+    ProcessingSystem<T, QueueT>& system_;
+    const size_t creditWindow_;
+    TcpListener listener_;
+    std::atomic<bool> running_{false};
+    std::thread acceptor_;
+    std::mutex connectionsMutex_;
+    std::list<std::unique_ptr<Connection>> connections_;
+    std::atomic<uint64_t> itemsReceived_{0};
+    std::atomic<uint64_t> batchesReceived_{0};
+};
+
+// Egress to another node: sends each delivered batch to a NetworkSource,
+// keyed results with their key. A delivery takes the credit it needs and
+// waits up to the timeout for more, so a node that falls behind pushes
+// back on this system's workers. Deliveries go out one at a time, in the
+// order they are made.
+template<typename T>
+class NetworkSink : public ResultSink<T> {
+public:
+    static constexpr size_t kMaxItemsPerFrame = 4096;
+
+    NetworkSink(const std::string& host, uint16_t port, int timeoutMs = 5000)
+        : address_(host + ":" + std::to_string(port)),
+          timeout_(timeoutMs),
+          socket_(TcpConnection::connect(host, port)) {
+        if (!socket_.isOpen()) {
+            broken_ = true;
+            return;
+        }
+        reader_ = std::thread(&NetworkSink::readCredits, this);
+    }
+
+    ~NetworkSink() override {
+        close();
+    }
+
+    NetworkSink(const NetworkSink&) = delete;
+    NetworkSink& operator=(const NetworkSink&) = delete;
+
+    size_t deliver(std::vector<T>& results) override {
+        return send(false, 0, results);
+    }
+
+    size_t deliverKeyed(PartitionKey key, std::vector<T>& results) override {
+        return send(true, key.id, results);
+    }
+
+    bool isConnected() const {
+        std::lock_guard<std::mutex> lock(creditMutex_);
+        return !broken_;
+    }
+
+    // Drop the connection; later deliveries are refused
+    void close() {
+        socket_.shutdown();
+        if (reader_.joinable()) reader_.join();
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        socket_.close();
+    }
+
+    uint64_t itemsSent() const {
+        return itemsSent_.load();
+    }
+
+    // Deliveries that had to wait for the receiver to return credit
+    uint64_t creditStalls() const {
+        return creditStalls_.load();
+    }
+
+private:
+    size_t send(bool keyed, uint64_t key, const std::vector<T>& results) {
+        std::lock_guard<std::mutex> sendLock(sendMutex_);
+        size_t sent = 0;
+        while (sent < results.size()) {
+            size_t n;
+            {
+                std::unique_lock<std::mutex> lock(creditMutex_);
+                if (credit_ == 0 && !broken_) {
+                    ++creditStalls_;
+                    if (!creditAvailable_.wait_for(lock, timeout_, [this] { return credit_ > 0 || broken_; })) {
+                        LOG_WARNING("No credit from " + address_ + " within timeout");
+                        break;
+                    }
+                }
+                if (broken_) break;
+                n = static_cast<size_t>(std::min<uint64_t>({credit_, results.size() - sent, kMaxItemsPerFrame}));
+                credit_ -= n;
+            }
+
+            beginFrame(frame_, FrameType::BATCH);
+            frame_.write(static_cast<uint8_t>(keyed));
+            if (keyed) frame_.writeVarint(key);
+            frame_.writeVarint(n);
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                frame_.writeBytes(results.data() + sent, n * sizeof(T));
+            } else {
+                for (size_t i = sent; i < sent + n; ++i) {
+                    frame_.write(results[i]);
+                }
+            }
+            if (!sendFrame(socket_, frame_)) {
+                LOG_ERROR("Send to " + address_ + " failed: " + socketError());
+                markBroken();
+                break;
+            }
+            sent += n;
+        }
+        itemsSent_ += sent;
+        return sent;
+    }
+
+    void readCredits() {
+        std::vector<uint8_t> body;
+        FrameType type;
+        while (receiveFrame(socket_, type, body)) {
+            ByteReader in(body);
+            uint64_t items = 0;
+            if (type != FrameType::CREDIT || !in.readVarint(items) || !in.atEnd()) {
+                LOG_ERROR("Unexpected frame from " + address_);
+                break;
+            }
+            std::lock_guard<std::mutex> lock(creditMutex_);
+            credit_ += items;
+            creditAvailable_.notify_all();
+        }
+        markBroken();
+    }
+
+    void markBroken() {
+        socket_.shutdown();
+        std::lock_guard<std::mutex> lock(creditMutex_);
+        broken_ = true;
+        creditAvailable_.notify_all();
+    }
+
+    const std::string address_;
+    const std::chrono::milliseconds timeout_;
+    TcpConnection socket_;
+    std::thread reader_;
+    std::mutex sendMutex_;
+    ByteWriter frame_;
+    mutable std::mutex creditMutex_;
+    std::condition_variable creditAvailable_;
+    uint64_t credit_ = 0;
+    bool broken_ = false;
+    std::atomic<uint64_t> itemsSent_{0};
+    std::atomic<uint64_t> creditStalls_{0};
+};
+
+// Spreads results over several nodes. A keyed result goes to the node
+// that owns its key, so with every node in SchedulingMode::PARTITIONED a
+// key has one owner in the whole cluster; unkeyed results take turns.
+// Producers can also call deliverKeyed directly to feed a cluster.
+template<typename T>
+class PartitionedNetworkSink : public ResultSink<T> {
+public:
+    explicit PartitionedNetworkSink(std::vector<std::shared_ptr<NetworkSink<T>>> nodes)
+        : nodes_(std::move(nodes)) {
+        if (nodes_.empty()) {
+            LOG_ERROR("Partitioned network sink needs at least one node");
+        }
+    }
+
+    size_t deliver(std::vector<T>& results) override {
+        if (nodes_.empty()) return 0;
+        size_t node = next_.fetch_add(1, std::memory_order_relaxed) % nodes_.size();
+        return nodes_[node]->deliver(results);
+    }
+
+    size_t deliverKeyed(PartitionKey key, std::vector<T>& results) override {
+        if (nodes_.empty()) return 0;
+        return nodes_[nodeForKey(key, nodes_.size())]->deliverKeyed(key, results);
+    }
+
+    // Taken from the high half of the hash, while a node picks its shard
+    // from the whole hash modulo its shard count, so the keys a node owns
+    // still spread over all of its shards
+    static size_t nodeForKey(PartitionKey key, size_t nodeCount) {
+        return static_cast<size_t>((partitionHash(key) >> 32) % nodeCount);
+    }
+
+    size_t nodeCount() const {
+        return nodes_.size();
+    }
+
+private:
+    std::vector<std::shared_ptr<NetworkSink<T>>> nodes_;
+    std::atomic<size_t> next_{0};
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// Identifies a partition in SchedulingMode::PARTITIONED, e.g. a sensor id
+struct PartitionKey {
+    explicit PartitionKey(uint64_t keyId = 0) : id(keyId) {}
+
+    // Key for a name, via 64-bit FNV-1a
+    static PartitionKey of(const std::string& name) {
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : name) {
+            hash = (hash ^ c) * 1099511628211ull;
+        }
+        return PartitionKey(hash);
+    }
+
+    bool operator==(const PartitionKey& other) const {
+        return id == other.id;
+    }
+
+    uint64_t id;
+};
+
+// Spreads key ids evenly over partitions. A ProcessingSystem picks the
+// owning shard from it, and PartitionedNetworkSink the owning node.
+inline uint64_t partitionHash(PartitionKey key) {
+    uint64_t x = key.id;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Result of an item added with a PartitionKey
+template<typename T>
+struct KeyedResult {
+    PartitionKey key;
+    T value;
+};
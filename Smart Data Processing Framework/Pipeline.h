@@ -0,0 +1,454 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <optional>
+
+#include "ProcessingSystem.h"
+#include "ProcessorFactory.h"
+#include "Logger.h"
+#include "Allocators.h"
+
+// Runs a chain of processors as one processor, so consecutive stages need
+// no intermediate queue. Runs of stateless stages are applied back to back
+// over the batch buffer; each stateful stage is guarded by its own lock,
+// which lets the stateless parts of the chain keep running in parallel.
+template<typename T>
+class CompositeProcessor : public Processor<T> {
+public:
+    explicit CompositeProcessor(std::vector<std::shared_ptr<Processor<T>>> stages) {
+        for (auto& stage : stages) {
+            stages_.push_back(Stage{stage, stage->isStateless()
+                ? nullptr : std::make_unique<std::mutex>()});
+        }
+    }
+
+    T process(const T& input) override {
+        T value = input;
+        for (auto& stage : stages_) {
+            if (stage.lock) {
+                std::lock_guard<std::mutex> lock(*stage.lock);
+                value = stage.processor->process(value);
+            } else {
+                value = stage.processor->process(value);
+            }
+        }
+        return value;
+    }
+
+    void processInPlace(T& value) override {
+        for (auto& stage : stages_) {
+            if (stage.lock) {
+                std::lock_guard<std::mutex> lock(*stage.lock);
+                stage.processor->processInPlace(value);
+            } else {
+                stage.processor->processInPlace(value);
+            }
+        }
+    }
+
+    // In place only pays off when every stage avoids the copy
+    bool processesInPlace() const override {
+        for (const auto& stage : stages_) {
+            if (!stage.processor->processesInPlace()) return false;
+        }
+        return true;
+    }
+
+    void processBatch(const T* in, T* out, size_t n) override {
+        const T* source = in;
+        for (auto& stage : stages_) {
+            if (stage.lock) {
+                std::lock_guard<std::mutex> lock(*stage.lock);
+                stage.processor->processBatch(source, out, n);
+            } else {
+                stage.processor->processBatch(source, out, n);
+            }
+            source = out; // Later stages work in place
+        }
+    }
+
+    bool dropsItems() const override {
+        for (const auto& stage : stages_) {
+            if (stage.processor->dropsItems()) return true;
+        }
+        return false;
+    }
+
+    std::optional<T> tryProcess(const T& input) override {
+        std::optional<T> value(input);
+        for (auto& stage : stages_) {
+            if (stage.lock) {
+                std::lock_guard<std::mutex> lock(*stage.lock);
+                value = stage.processor->tryProcess(*value);
+            } else {
+                value = stage.processor->tryProcess(*value);
+            }
+            if (!value) break;
+        }
+        return value;
+    }
+
+    // Each stage only sees what the stages before it kept
+    size_t processBatchFiltered(const T* in, T* out, uint8_t* keep, size_t n) override {
+        std::fill(keep, keep + n, uint8_t(1));
+        ScratchScope scratch;
+        ArenaVector<uint8_t> stageKeep(scratch.allocator<uint8_t>());
+        const T* source = in;
+        size_t count = n;
+        for (auto& stage : stages_) {
+            std::unique_lock<std::mutex> lock;
+            if (stage.lock) {
+                lock = std::unique_lock<std::mutex>(*stage.lock);
+            }
+            if (!stage.processor->dropsItems()) {
+                stage.processor->processBatch(source, out, count);
+            } else {
+                stageKeep.resize(count);
+                size_t kept = stage.processor->processBatchFiltered(source, out, stageKeep.data(), count);
+                if (kept < count) {
+                    // Map the stage's verdicts back onto the original items
+                    size_t survivor = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        if (keep[i]) keep[i] = stageKeep[survivor++];
+                    }
+                }
+                count = kept;
+            }
+            source = out;
+            if (count == 0) break;
+        }
+        return count;
+    }
+
+    std::string getName() const override {
+        std::string name;
+        for (const auto& stage : stages_) {
+            if (!name.empty()) name += " -> ";
+            name += stage.processor->getName();
+        }
+        return name;
+    }
+
+    // Null if any stage cannot be cloned
+    std::shared_ptr<Processor<T>> clone() const override {
+        std::vector<std::shared_ptr<Processor<T>>> stages;
+        for (const auto& stage : stages_) {
+            auto copy = stage.processor->clone();
+            if (!copy) return nullptr;
+            stages.push_back(copy);
+        }
+        return std::make_shared<CompositeProcessor>(stages);
+    }
+
+    // Safe to share: stateful stages serialize themselves
+    bool isStateless() const override {
+        return true;
+    }
+
+    // The locks do not keep a stateful stage's input in order, so in
+    // ordered mode a chain with one runs in order as a whole
+    bool needsInputOrder() const override {
+        for (const auto& stage : stages_) {
+            if (stage.processor->needsInputOrder()) return true;
+        }
+        return false;
+    }
+
+    // A failed batch is rerun item by item, which would apply the items
+    // before the failure twice in a stateful stage
+    bool canRetryBatch() const override {
+        for (const auto& stage : stages_) {
+            if (!stage.processor->canRetryBatch()) return false;
+        }
+        return true;
+    }
+
+    bool isPure() const override {
+        for (const auto& stage : stages_) {
+            if (!stage.processor->isPure()) return false;
+        }
+        return true;
+    }
+
+    CacheCounters cacheCounters() const override {
+        CacheCounters total;
+        for (const auto& stage : stages_) {
+            CacheCounters counters = stage.processor->cacheCounters();
+            total.hits += counters.hits;
+            total.misses += counters.misses;
+        }
+        return total;
+    }
+
+    void reset() override {
+        for (auto& stage : stages_) {
+            stage.processor->reset();
+        }
+    }
+
+    // Stage by stage, each under its own lock
+    bool snapshot(ByteWriter& out) const override {
+        for (const auto& stage : stages_) {
+            std::unique_lock<std::mutex> lock;
+            if (stage.lock) lock = std::unique_lock<std::mutex>(*stage.lock);
+            if (!stage.processor->snapshot(out)) return false;
+        }
+        return true;
+    }
+
+    bool restore(ByteReader& in) override {
+        for (auto& stage : stages_) {
+            std::unique_lock<std::mutex> lock;
+            if (stage.lock) lock = std::unique_lock<std::mutex>(*stage.lock);
+            if (!stage.processor->restore(in)) return false;
+        }
+        return true;
+    }
+
+private:
+    struct Stage {
+        std::shared_ptr<Processor<T>> processor;
+        std::unique_ptr<std::mutex> lock;
+    };
+
+    std::vector<Stage> stages_;
+};
+
+// Builder for multi-stage processing. Stages added with then() are fused
+// into a single pass; boundary() starts a new segment with its own input
+// queue and worker pool. Segments hand results directly to the next
+// segment's input queue.
+//
+//   Pipeline<int> pipeline(4);
+//   pipeline.then(ProcessorType::FILTERING, {{"threshold", 5.0}})
+//           .then(ProcessorType::AMPLIFICATION, {{"gain", 2.0}})
+//           .boundary(1)
+//           .then(ProcessorType::STATISTICAL);
+//   pipeline.start();
+template<typename T, template<typename> class QueueT = DataQueue>
+class Pipeline {
+public:
+    explicit Pipeline(size_t numWorkers = 4, size_t queueSize = 10000)
+        : isRunning_(false) {
+        specs_.push_back(SegmentSpec{numWorkers, queueSize, {}});
+    }
+
+    ~Pipeline() {
+        stop();
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Append a stage to the current segment
+    Pipeline& then(std::shared_ptr<Processor<T>> processor) {
+        if (!processor) {
+            LOG_ERROR("Pipeline: cannot add a null processor");
+            return *this;
+        }
+        specs_.back().stages.push_back(processor);
+        return *this;
+    }
+
+    Pipeline& then(ProcessorType type, const std::map<std::string, double>& params = {}) {
+        return then(ProcessorFactory<T>::getInstance().createProcessor(type, params));
+    }
+
+    Pipeline& then(const ProcessorConfig& config) {
+        return then(ProcessorFactory<T>::getInstance().createProcessor(config));
+    }
+
+    // Start a new segment with its own queue and workers
+    Pipeline& boundary(size_t numWorkers, size_t queueSize = 10000) {
+        if (specs_.back().stages.empty()) {
+            LOG_WARNING("Pipeline: boundary() after an empty segment replaces its settings");
+            specs_.back().numWorkers = numWorkers;
+            specs_.back().queueSize = queueSize;
+            return *this;
+        }
+        specs_.push_back(SegmentSpec{numWorkers, queueSize, {}});
+        return *this;
+    }
+
+    // Push results of the last segment to sink instead of its output queue
+    void setResultSink(std::shared_ptr<ResultSink<T>> sink) {
+        sink_ = sink;
+        if (!segments_.empty()) {
+            segments_.back()->setResultSink(sink);
+        }
+    }
+
+    void start() {
+        if (isRunning_) {
+            LOG_WARNING("Pipeline already running");
+            return;
+        }
+        if (specs_.back().stages.empty()) {
+            LOG_ERROR("Pipeline: last segment has no stages");
+            return;
+        }
+
+        segments_.clear();
+        for (const auto& spec : specs_) {
+            auto segment = std::make_unique<ProcessingSystem<T, QueueT>>(
+                spec.numWorkers, spec.queueSize);
+            if (spec.stages.size() == 1) {
+                segment->setProcessor(spec.stages.front());
+            } else {
+                segment->setProcessor(std::make_shared<CompositeProcessor<T>>(spec.stages));
+            }
+            segments_.push_back(std::move(segment));
+        }
+        for (size_t i = 0; i + 1 < segments_.size(); ++i) {
+            segments_[i]->connectTo(segments_[i + 1].get());
+        }
+        if (sink_) {
+            segments_.back()->setResultSink(sink_);
+        }
+
+        // Downstream first, so nothing is handed to a stopped segment
+        for (auto it = segments_.rbegin(); it != segments_.rend(); ++it) {
+            (*it)->start();
+        }
+        isRunning_ = true;
+        LOG_INFO("Pipeline started with " + std::to_string(segments_.size()) +
+                 " segment(s): " + describe());
+    }
+
+    // Stops segments front to back so every segment drains into the next.
+    // Results stay available from getResults() until the next start().
+    void stop() {
+        if (!isRunning_) return;
+        isRunning_ = false;
+        for (auto& segment : segments_) {
+            segment->stop();
+        }
+        LOG_INFO("Pipeline stopped");
+    }
+
+    // Wait until everything added so far has reached the end of the
+    // pipeline. Segments drain front to back, each one only after the
+    // segment before it has handed everything on.
+    bool drain(int timeoutMs = -1) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        for (auto& segment : segments_) {
+            int remaining = -1;
+            if (timeoutMs > 0) {
+                remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count());
+                if (remaining <= 0) return false;
+            }
+            if (!segment->drain(remaining)) return false;
+        }
+        return true;
+    }
+
+    bool addData(const T& data, int timeoutMs = 1000) {
+        if (!isRunning_) {
+            LOG_WARNING("Pipeline not started. Cannot add data.");
+            return false;
+        }
+        return segments_.front()->addData(data, timeoutMs);
+    }
+
+    bool addData(T&& data, int timeoutMs = 1000) {
+        if (!isRunning_) {
+            LOG_WARNING("Pipeline not started. Cannot add data.");
+            return false;
+        }
+        return segments_.front()->addData(std::move(data), timeoutMs);
+    }
+
+    template<typename ForwardIt>
+    size_t addBatch(ForwardIt first, ForwardIt last, int timeoutMs = 1000) {
+        if (!isRunning_) {
+            LOG_WARNING("Pipeline not started. Cannot add data.");
+            return 0;
+        }
+        return segments_.front()->addBatch(first, last, timeoutMs);
+    }
+
+    size_t addBatch(const std::vector<T>& data, int timeoutMs = 1000) {
+        if (!isRunning_) {
+            LOG_WARNING("Pipeline not started. Cannot add data.");
+            return 0;
+        }
+        return segments_.front()->addBatch(data, timeoutMs);
+    }
+
+    size_t addBatch(std::vector<T>&& data, int timeoutMs = 1000) {
+        if (!isRunning_) {
+            LOG_WARNING("Pipeline not started. Cannot add data.");
+            return 0;
+        }
+        return segments_.front()->addBatch(std::move(data), timeoutMs);
+    }
+
+    std::optional<T> getResult(int timeoutMs = 1000) {
+        if (segments_.empty()) return std::nullopt;
+        return segments_.back()->getResult(timeoutMs);
+    }
+
+    std::vector<T> getResults(size_t count, int timeoutMs = 100) {
+        if (segments_.empty()) return {};
+        return segments_.back()->getResults(count, timeoutMs);
+    }
+
+    std::vector<T> drainResults(size_t maxCount, int timeoutMs = 100) {
+        if (segments_.empty()) return {};
+        return segments_.back()->drainResults(maxCount, timeoutMs);
+    }
+
+    size_t segmentCount() const {
+        return specs_.size();
+    }
+
+    // e.g. "[FilteringProcessor -> AmplificationProcessor] | [StatisticalProcessor]"
+    std::string describe() const {
+        std::string description;
+        for (const auto& spec : specs_) {
+            if (!description.empty()) description += " | ";
+            description += "[";
+            for (size_t i = 0; i < spec.stages.size(); ++i) {
+                if (i > 0) description += " -> ";
+                description += spec.stages[i]->getName();
+            }
+            description += "]";
+        }
+        return description;
+    }
+
+    // One snapshot per segment, front to back
+    std::vector<SystemMetrics> getMetrics() const {
+        std::vector<SystemMetrics> metrics;
+        for (const auto& segment : segments_) {
+            metrics.push_back(segment->getMetrics());
+        }
+        return metrics;
+    }
+
+    void printStatistics() const {
+        for (size_t i = 0; i < segments_.size(); ++i) {
+            LOG_INFO("--- Pipeline segment " + std::to_string(i) + " ---");
+            segments_[i]->printStatistics();
+        }
+    }
+
+private:
+    struct SegmentSpec {
+        size_t numWorkers;
+        size_t queueSize;
+        std::vector<std::shared_ptr<Processor<T>>> stages;
+    };
+
+    std::vector<SegmentSpec> specs_;
+    std::vector<std::unique_ptr<ProcessingSystem<T, QueueT>>> segments_;
+    std::shared_ptr<ResultSink<T>> sink_;
+    bool isRunning_;
+};
@@ -7,22 +7,94 @@
 #include <unordered_map>
 #include <functional>
 #include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <future>
 
 #include "DataQueue.h"
+#include "RingBufferQueue.h"
+#include "WorkStealingDeque.h"
 #include "Processor.h"
 #include "ProcessorFactory.h"
 #include "Logger.h"
+#include "Metrics.h"
+#include "ShardedCounter.h"
+#include "ReorderBuffer.h"
+#include "ResultSink.h"
+#include "Allocators.h"
+#include "Topology.h"
+#include "Checkpoint.h"
+#include "CheckpointFile.h"
+#include "AsyncProcessor.h"
 
-template<typename T>
+// How input is handed to workers
+enum class SchedulingMode {
+    SHARED_QUEUE,   // All workers consume one input queue
+    WORK_STEALING,  // Each worker owns an input shard; idle workers steal
+    PARTITIONED     // Keyed items always go to the worker that owns the key
+};
+
+// How producers pick a shard in SchedulingMode::WORK_STEALING (and for
+// unkeyed items in SchedulingMode::PARTITIONED)
+enum class DistributionPolicy {
+    ROUND_ROBIN,     // Spread successive items/batches over all workers
+    THREAD_AFFINITY  // Each producer thread always feeds the same worker
+};
+
+// What addData()/addBatch() do when the input queue is full
+enum class BackpressurePolicy {
+    BLOCK,        // Wait up to the call's timeout, then reject the item
+    DROP_NEWEST,  // Reject the new item straight away
+    DROP_OLDEST,  // Discard the oldest queued item to make room
+    CALLER_RUNS   // Process the item on the calling thread
+};
+
+// QueueT selects the queue backend: DataQueue (mutex + condition variables)
+// or RingBufferQueue (lock-free ring)
+template<typename T, template<typename> class QueueT = DataQueue>
 class ProcessingSystem {
 public:
     explicit ProcessingSystem(size_t numWorkers = 4, size_t queueSize = 10000)
         : numWorkers_(numWorkers), 
+          workerBatchSize_(kDefaultWorkerBatchSize),
+          queueSize_(queueSize),
+          schedulingMode_(SchedulingMode::SHARED_QUEUE),
+          distributionPolicy_(DistributionPolicy::ROUND_ROBIN),
+          backpressure_(BackpressurePolicy::BLOCK),
+          placement_(PlacementPolicy::NONE),
           inputQueue_(queueSize),
           outputQueue_(queueSize),
           isRunning_(false),
-          totalProcessed_(0),
-          totalErrors_(0) {
+          elastic_(false),
+          minWorkers_(numWorkers),
+          maxWorkers_(numWorkers),
+          scaleIntervalMs_(kDefaultScaleIntervalMs),
+          activeWorkers_(numWorkers),
+          idleWorkers_(0),
+          inFlight_(0),
+          shardsClosed_(false),
+          nextShard_(0),
+          downstream_(nullptr),
+          orderedOutput_(false),
+          reorderWindow_(kDefaultReorderWindow),
+          nextSequence_(0),
+          processorVersion_(0),
+          sinkVersion_(0),
+          totalProcessed_(numWorkers),
+          totalErrors_(numWorkers),
+          totalFiltered_(numWorkers) {
+        for (size_t i = 0; i < numWorkers; ++i) {
+            workerMetrics_.push_back(std::make_unique<WorkerMetrics>());
+        }
+        callerContext_.workerId = numWorkers;
+        callerContext_.metrics = &callerMetrics_;
         LOG_INFO("ProcessingSystem initialized with " + std::to_string(numWorkers) + " workers");
     }
 
@@ -45,18 +117,73 @@ public:
             return;
         }
 
-        if (!processor_) {
+        if (!std::atomic_load(&processor_)) {
             LOG_ERROR("No processor assigned. Use setProcessor() first.");
             isRunning_ = false;
             return;
         }
 
-        LOG_INFO("Starting ProcessingSystem with " + std::to_string(numWorkers_) + " worker threads");
+        bool elastic = elastic_;
+        if (elastic && usesShards()) {
+            LOG_WARNING("Elastic workers need the shared input queue; pool size fixed");
+            elastic = false;
+        }
+        size_t initialWorkers = elastic
+            ? std::min(std::max(numWorkers_, minWorkers_), maxWorkers_) : numWorkers_;
+        activeWorkers_.store(initialWorkers);
+
+        LOG_INFO("Starting ProcessingSystem with " + std::to_string(initialWorkers) + " worker threads");
+
+        if (orderedOutput_ && schedulingMode_ == SchedulingMode::PARTITIONED) {
+            LOG_WARNING("Ordered output ignored: partitioned mode already keeps each key in order");
+            orderedOutput_ = false;
+        }
+        if (orderedOutput_) {
+            if (schedulingMode_ == SchedulingMode::WORK_STEALING) {
+                LOG_WARNING("Ordered output needs the shared input queue; work stealing disabled");
+                schedulingMode_ = SchedulingMode::SHARED_QUEUE;
+            }
+            reorder_ = std::make_unique<ReorderBuffer<T>>(reorderWindow_, nextSequence_);
+        } else {
+            reorder_.reset();
+        }
+
+        // A stopped system can be started again: stop() shut the queue
+        inputQueue_.reopen();
+        configureInputLanes();
+
+        workerCpus_ = assignCpus(topology_, placement_, std::max(numWorkers_, maxWorkers_));
+
+        if (usesShards()) {
+            size_t shardCapacity = std::max(queueSize_ / std::max<size_t>(numWorkers_, 1),
+                                            workerBatchSize_);
+            shards_.clear();
+            for (size_t i = 0; i < numWorkers_; ++i) {
+                if (workerCpus_.empty()) {
+                    shards_.push_back(std::make_unique<WorkerShard>(shardCapacity));
+                    continue;
+                }
+                // Built from the worker's CPU, so first touch puts the
+                // shard's memory on the worker's node
+                std::unique_ptr<WorkerShard> shard;
+                runPinned(workerCpus_[i], [&] {
+                    shard = std::make_unique<WorkerShard>(shardCapacity);
+                });
+                shards_.push_back(std::move(shard));
+            }
+            mapShardsToNodes();
+            installRestoredPartitions();
+            shardsClosed_.store(false, std::memory_order_release);
+        }
 
         // Create worker threads
-        for (size_t i = 0; i < numWorkers_; ++i) {
+        for (size_t i = 0; i < initialWorkers; ++i) {
             workers_.emplace_back(&ProcessingSystem::workerThread, this, i);
         }
+        if (elastic) {
+            scaler_ = std::thread(&ProcessingSystem::scalerThread, this);
+        }
+        requeueRestoredInput();
     }
 
     // Stop the processing system
@@ -67,7 +194,30 @@ public:
 
         LOG_INFO("Stopping ProcessingSystem");
 
+        {
+            std::lock_guard<std::mutex> lock(scalerMutex_);
+        }
+        scalerWake_.notify_all();
+        if (scaler_.joinable()) {
+            scaler_.join();
+        }
+        {
+            // Parked workers wake up to help drain what is left
+            std::lock_guard<std::mutex> lock(parkMutex_);
+        }
+        parked_.notify_all();
+
+        // Shutting the queues wakes every waiting worker; they drain what
+        // is left and exit
         inputQueue_.shutdown();
+        for (auto& shard : shards_) {
+            shard->inbox.shutdown();
+        }
+        shardsClosed_.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(idleMutex_);
+        }
+        workAvailable_.notify_all();
 
         // Wait for all workers to finish
         for (auto& worker : workers_) {
@@ -78,15 +228,40 @@ public:
         workers_.clear();
 
         LOG_INFO("ProcessingSystem stopped. Total processed: " + 
-                std::to_string(totalProcessed_) + 
-                ", Errors: " + std::to_string(totalErrors_));
+                std::to_string(totalProcessed_.load()) + 
+                ", Errors: " + std::to_string(totalErrors_.load()));
+    }
+
+    // Wait until every item accepted so far has been processed and handed
+    // on to the output queue, sink or connected system. Returns as soon as
+    // the last one is done; items added meanwhile are waited for as well.
+    // Returns false if timeoutMs (when positive) expired first.
+    bool drain(int timeoutMs = -1) {
+        std::unique_lock<std::mutex> lock(drainMutex_);
+        auto idle = [this] { return inFlight_.load(std::memory_order_acquire) == 0; };
+        if (timeoutMs > 0) {
+            return drained_.wait_for(lock, std::chrono::milliseconds(timeoutMs), idle);
+        }
+        drained_.wait(lock, idle);
+        return true;
     }
 
-    // Set the processor to use
+    // Set the processor to use. Safe to call while running: workers pick up
+    // the new processor on their next item without blocking.
     void setProcessor(std::shared_ptr<Processor<T>> processor) {
-        std::lock_guard<std::mutex> lock(processorMutex_);
-        processor_ = processor;
-        LOG_INFO("Processor set: " + processor_->getName());
+        if (!processor) {
+            LOG_ERROR("Cannot set a null processor");
+            return;
+        }
+        std::atomic_store(&processor_, processor);
+        processorVersion_.fetch_add(1, std::memory_order_release);
+        LOG_DEBUG("Processor set: " + processor->getName());
+    }
+
+    // Swap in an instance of a prebuilt prototype; shares it when it is
+    // stateless, so no allocation is made
+    void setProcessor(const ProcessorPrototype<T>& prototype) {
+        setProcessor(prototype.instance());
     }
 
     // Set processor by type and parameters (using Factory)
@@ -97,13 +272,283 @@ public:
         setProcessor(processor);
     }
 
+    void setProcessorByType(const ProcessorConfig& config) {
+        setProcessor(ProcessorFactory<T>::getInstance().createProcessor(config));
+    }
+
+#if SDPF_HAS_COROUTINES
+    // Run an I/O-bound processor on coroutines: each worker keeps up to
+    // maxInFlight items in progress on an event loop of its own. Before
+    // start() this also raises the worker batch size to maxInFlight, so
+    // every wake-up can fill the loop.
+    void setAsyncProcessor(std::shared_ptr<AsyncProcessor<T>> processor,
+                           size_t maxInFlight = AsyncStage<T>::kDefaultMaxInFlight) {
+        if (!isRunning_) {
+            workerBatchSize_ = std::max(workerBatchSize_, maxInFlight);
+        }
+        setProcessor(std::make_shared<AsyncStage<T>>(std::move(processor), maxInFlight));
+    }
+#endif
+
+    // Deliver results straight into another system's input queue instead of
+    // this system's output queue, so chained systems share one queue per
+    // hop. Pass nullptr to disconnect.
+    void connectTo(ProcessingSystem* downstream) {
+        downstream_.store(downstream, std::memory_order_release);
+    }
+
+    // Hand results to sink from the worker threads instead of the output
+    // queue, so nobody has to poll for them. Safe to call while running;
+    // pass nullptr to go back to the output queue. connectTo() takes
+    // precedence over a sink.
+    void setResultSink(std::shared_ptr<ResultSink<T>> sink) {
+        std::atomic_store(&sink_, sink);
+        sinkVersion_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Call back once per result, concurrently from the workers
+    void setResultCallback(typename CallbackSink<T>::Callback callback) {
+        setResultSink(std::make_shared<CallbackSink<T>>(std::move(callback)));
+    }
+
+    // Call back once per worker batch, concurrently from the workers
+    void setBatchResultCallback(typename BatchCallbackSink<T>::Callback callback) {
+        setResultSink(std::make_shared<BatchCallbackSink<T>>(std::move(callback)));
+    }
+
+    // Deliver into a queue owned by the caller
+    template<template<typename> class UserQueueT>
+    void setResultQueue(std::shared_ptr<UserQueueT<T>> queue, int timeoutMs = 500) {
+        setResultSink(std::make_shared<QueueSink<T, UserQueueT>>(std::move(queue), timeoutMs));
+    }
+
+    bool isRunning() const {
+        return isRunning_.load();
+    }
+
+    SchedulingMode getSchedulingMode() const {
+        return schedulingMode_;
+    }
+
+    // Choose how input reaches workers. Must be set before start().
+    void setSchedulingMode(SchedulingMode mode,
+                           DistributionPolicy distribution = DistributionPolicy::ROUND_ROBIN) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot change scheduling mode while running");
+            return;
+        }
+        schedulingMode_ = mode;
+        distributionPolicy_ = distribution;
+        if (mode == SchedulingMode::PARTITIONED && !keyedOutputQueue_) {
+            keyedOutputQueue_ = std::make_unique<QueueT<KeyedResult<T>>>(queueSize_);
+        }
+    }
+
+    // Release results in the order their inputs were added, while workers
+    // still process in parallel. Up to window results that finished ahead
+    // of an earlier one are held back; beyond that, workers wait, which in
+    // turn backs up the input queue. Stateful processors additionally see
+    // their input in order. Must be set before start().
+    void setOrderedOutput(bool enabled, size_t window = kDefaultReorderWindow) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot change ordered output while running");
+            return;
+        }
+        orderedOutput_ = enabled;
+        reorderWindow_ = window > 0 ? window : 1;
+    }
+
+    // Pin each worker to a CPU of topology. In the sharded scheduling
+    // modes every worker's input shard is also allocated from its CPU, so
+    // it lives on the worker's NUMA node; producers then prefer shards on
+    // their own node, and idle workers steal from their own node first.
+    // Must be set before start().
+    void setPlacement(PlacementPolicy policy, CpuTopology topology = CpuTopology::detect()) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot change worker placement while running");
+            return;
+        }
+        placement_ = policy;
+        topology_ = std::move(topology);
+    }
+
+    // Split the shared input queue into priority lanes, each with its own
+    // capacity (together they replace queueSize) and weight. addData() and
+    // addBatch() feed lane 0; addDataToLane()/addBatchToLane() choose.
+    // Workers serve the lanes by deficit round-robin (see DataQueue), so
+    // backfill piling up in one lane adds at most one round of weights to
+    // the queue wait of live items in another. Needs the DataQueue backend
+    // and the shared input queue without ordered output; otherwise the
+    // lanes are ignored at start(). Must be set before start().
+    void setPriorityLanes(std::vector<LaneConfig> lanes) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot change priority lanes while running");
+            return;
+        }
+        if constexpr (!kDataQueue) {
+            LOG_ERROR("Priority lanes need the DataQueue backend");
+            return;
+        }
+        for (size_t i = 0; i < lanes.size(); ++i) {
+            if (lanes[i].capacity == 0) {
+                LOG_ERROR("Priority lane " + std::to_string(i) + " has no capacity");
+                return;
+            }
+        }
+        inputLanes_ = std::move(lanes);
+    }
+
+    // What producers do when the input queue (or a shard) is full. Items
+    // dropped under DROP_NEWEST/DROP_OLDEST are counted as shed. Keyed
+    // items never run on the caller, since their state lives with the
+    // owning worker; CALLER_RUNS blocks for them instead. Must be set
+    // before start().
+    void setBackpressurePolicy(BackpressurePolicy policy) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot change backpressure policy while running");
+            return;
+        }
+        backpressure_ = policy;
+    }
+
+    // Let the pool grow and shrink between minWorkers and maxWorkers. Every
+    // scaleIntervalMs the input queue depth and worker utilization decide
+    // whether to wake one more worker or park one; parked workers sleep
+    // until needed. The constructor's worker count is the starting size.
+    // SchedulingMode::SHARED_QUEUE only. Must be set before start().
+    void setElasticWorkers(size_t minWorkers, size_t maxWorkers,
+                           int scaleIntervalMs = kDefaultScaleIntervalMs) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot change worker pool bounds while running");
+            return;
+        }
+        minWorkers_ = std::max<size_t>(minWorkers, 1);
+        maxWorkers_ = std::max(maxWorkers, minWorkers_);
+        scaleIntervalMs_ = scaleIntervalMs > 0 ? scaleIntervalMs : kDefaultScaleIntervalMs;
+        elastic_ = true;
+        while (workerMetrics_.size() < maxWorkers_) {
+            workerMetrics_.push_back(std::make_unique<WorkerMetrics>());
+        }
+    }
+
+    // Maximum number of items a worker takes from the input queue per wake-up.
+    // Must be set before start().
+    void setWorkerBatchSize(size_t batchSize) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot change worker batch size while running");
+            return;
+        }
+        workerBatchSize_ = batchSize > 0 ? batchSize : 1;
+    }
+
     // Add data to processing queue
     bool addData(const T& data, int timeoutMs = 1000) {
+        return submit(data, timeoutMs);
+    }
+
+    // Move the payload in; it is not copied again on its way to the result
+    bool addData(T&& data, int timeoutMs = 1000) {
+        return submit(std::move(data), timeoutMs);
+    }
+
+    // Add a batch of data in one queue operation (one per worker-sized
+    // slice in work-stealing mode).
+    // Returns how many items were accepted before timeoutMs expired.
+    template<typename ForwardIt>
+    size_t addBatch(ForwardIt first, ForwardIt last, int timeoutMs = 1000) {
+        return addBatchToLane(0, first, last, timeoutMs);
+    }
+
+    size_t addBatch(const std::vector<T>& data, int timeoutMs = 1000) {
+        return addBatch(data.begin(), data.end(), timeoutMs);
+    }
+
+    // Moves the items in; the ones not accepted are left moved-from
+    size_t addBatch(std::vector<T>&& data, int timeoutMs = 1000) {
+        return addBatch(std::make_move_iterator(data.begin()),
+                        std::make_move_iterator(data.end()), timeoutMs);
+    }
+
+    // Priority lanes (setPriorityLanes()): add to one lane. Lane 0 is the
+    // one addData() uses; while lanes are not in effect, every lane is.
+    bool addDataToLane(size_t lane, const T& data, int timeoutMs = 1000) {
+        return isLane(lane) && submit(data, timeoutMs, lane);
+    }
+
+    bool addDataToLane(size_t lane, T&& data, int timeoutMs = 1000) {
+        return isLane(lane) && submit(std::move(data), timeoutMs, lane);
+    }
+
+    template<typename ForwardIt>
+    size_t addBatchToLane(size_t lane, ForwardIt first, ForwardIt last, int timeoutMs = 1000) {
+        if (!isLane(lane)) {
+            return 0;
+        }
         if (!isRunning_) {
             LOG_WARNING("System not running. Cannot add data.");
-            return false;
+            return 0;
         }
-        return inputQueue_.enqueue(data, timeoutMs);
+
+        // The whole batch shares one timestamp. Items are staged in the
+        // thread's scratch arena, so adding a batch allocates nothing.
+        ScratchScope scratch;
+        ItemBuffer items(scratch.allocator<WorkItem>());
+        items.reserve(static_cast<size_t>(std::distance(first, last)));
+        int64_t now = monotonicNanos();
+        for (; first != last; ++first) {
+            items.emplace_back(*first, now);
+        }
+
+        return enqueueItems(items, timeoutMs, lane);
+    }
+
+    size_t addBatchToLane(size_t lane, const std::vector<T>& data, int timeoutMs = 1000) {
+        return addBatchToLane(lane, data.begin(), data.end(), timeoutMs);
+    }
+
+    size_t addBatchToLane(size_t lane, std::vector<T>&& data, int timeoutMs = 1000) {
+        return addBatchToLane(lane, std::make_move_iterator(data.begin()),
+                              std::make_move_iterator(data.end()), timeoutMs);
+    }
+
+    // SchedulingMode::PARTITIONED: every key is owned by one worker, which
+    // runs its items through a private clone() of the processor, so
+    // stateful processors keep per-key state without any locking. Results
+    // are read back with getKeyedResult()/pollKeyedResults(). Partition
+    // state starts from the processor set at the time and lasts until
+    // stop() or the next setProcessor().
+    bool addData(PartitionKey key, const T& data, int timeoutMs = 1000) {
+        return submitKeyed(key, data, timeoutMs);
+    }
+
+    bool addData(PartitionKey key, T&& data, int timeoutMs = 1000) {
+        return submitKeyed(key, std::move(data), timeoutMs);
+    }
+
+    // Add several items for one key in a single queue operation
+    size_t addBatch(PartitionKey key, const std::vector<T>& data, int timeoutMs = 1000) {
+        return submitKeyedBatch(key, data.begin(), data.end(), timeoutMs);
+    }
+
+    size_t addBatch(PartitionKey key, std::vector<T>&& data, int timeoutMs = 1000) {
+        return submitKeyedBatch(key, std::make_move_iterator(data.begin()),
+                                std::make_move_iterator(data.end()), timeoutMs);
+    }
+
+    template<typename ForwardIt>
+    size_t addBatch(PartitionKey key, ForwardIt first, ForwardIt last, int timeoutMs = 1000) {
+        return submitKeyedBatch(key, first, last, timeoutMs);
+    }
+
+    std::optional<KeyedResult<T>> getKeyedResult(int timeoutMs = 1000) {
+        if (!keyedOutputQueue_) return std::nullopt;
+        return keyedOutputQueue_->dequeue(timeoutMs);
+    }
+
+    size_t pollKeyedResults(std::vector<KeyedResult<T>>& out, size_t maxCount,
+                            int timeoutMs = 100) {
+        if (!keyedOutputQueue_) return 0;
+        return keyedOutputQueue_->dequeueBulk(out, maxCount, timeoutMs);
     }
 
     // Get processed data from output queue
@@ -111,102 +556,1658 @@ public:
         return outputQueue_.dequeue(timeoutMs);
     }
 
-    // Get multiple results
+    // Get multiple results. Stops at the first wait that times out instead
+    // of waiting out timeoutMs once per missing result.
     std::vector<T> getResults(size_t count, int timeoutMs = 100) {
         std::vector<T> results;
-        for (size_t i = 0; i < count; ++i) {
-            auto result = outputQueue_.dequeue(timeoutMs);
-            if (result) {
-                results.push_back(result.value());
+        results.reserve(count);
+        while (results.size() < count) {
+            if (outputQueue_.dequeueBulk(results, count - results.size(), timeoutMs) == 0) {
+                break;
+            }
+        }
+        return results;
+    }
+
+    // Append up to maxCount results to out, waiting only for the first one.
+    // Suited to collector loops: nothing is held back to fill a batch.
+    size_t pollResults(std::vector<T>& out, size_t maxCount, int timeoutMs = 100) {
+        return outputQueue_.dequeueBulk(out, maxCount, timeoutMs);
+    }
+
+    // Collect up to maxCount results, waiting at most timeoutMs in total
+    std::vector<T> drainResults(size_t maxCount, int timeoutMs = 100) {
+        std::vector<T> results;
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeoutMs);
+        while (results.size() < maxCount) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                break;
             }
+            outputQueue_.dequeueBulk(results, maxCount - results.size(),
+                                     static_cast<int>(remaining));
         }
         return results;
     }
 
+    // Save the processor's state (every key's, in partitioned mode) and a
+    // copy of the items waiting in the input and output queues to path.
+    // Workers keep running: each state is read under the lock its
+    // processor already runs under and each queue is copied under its
+    // own, one at a time. Encoding and writing happen on a background
+    // thread; the future tells whether the file was written (and its
+    // destructor waits for that). Items a worker is processing at that
+    // moment are in neither, so for an exact checkpoint pause producers
+    // and drain() first. Queue contents need the DataQueue backend; the
+    // payload type needs a Codec (see Checkpoint.h).
+    std::future<bool> checkpoint(const std::string& path) {
+        auto processor = std::atomic_load(&processor_);
+        if (!processor) {
+            LOG_ERROR("No processor assigned; nothing to checkpoint");
+            std::promise<bool> failed;
+            failed.set_value(false);
+            return failed.get_future();
+        }
+
+        CheckpointData data;
+        data.processorName = processor->getName();
+        {
+            std::unique_lock<std::mutex> lock;
+            if (!processor->isStateless()) {
+                lock = std::unique_lock<std::mutex>(serialMutex_);
+            }
+            ByteWriter state;
+            data.hasState = processor->snapshot(state);
+            data.state = std::move(state.bytes());
+        }
+        if (!data.hasState) {
+            LOG_WARNING(data.processorName + " cannot save its state; checkpoint holds queues only");
+        }
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->partitionMutex);
+            for (const auto& [key, partition] : shard->partitions) {
+                ByteWriter state;
+                if (partition->snapshot(state)) {
+                    data.partitions.emplace_back(key, std::move(state.bytes()));
+                }
+            }
+        }
+        if constexpr (kDataQueue) {
+            inputQueue_.copyItems(data.input);
+            for (const auto& shard : shards_) {
+                shard->inbox.copyItems(data.input);
+            }
+            outputQueue_.copyItems(data.output);
+            if (keyedOutputQueue_) {
+                keyedOutputQueue_->copyItems(data.keyedOutput);
+            }
+        } else {
+            LOG_WARNING("Queue contents are only saved with the DataQueue backend");
+        }
+
+        return std::async(std::launch::async, [data = std::move(data), path] {
+            return writeFileAtomically(path, encodeCheckpoint(data));
+        });
+    }
+
+    // Load a checkpoint written by checkpoint(), after setProcessor() and
+    // setSchedulingMode() but before start(). The processor must be the
+    // kind the checkpoint came from; its name is checked. Saved results
+    // go back into the output queues at once; saved input is requeued by
+    // start(), and saved partitions go to the workers owning their keys.
+    // Returns false, changing nothing, if the file is missing, damaged
+    // or from another processor.
+    bool restoreCheckpoint(const std::string& path) {
+        if (isRunning_) {
+            LOG_WARNING("Cannot restore a checkpoint while running");
+            return false;
+        }
+        auto processor = std::atomic_load(&processor_);
+        if (!processor) {
+            LOG_ERROR("No processor assigned. Use setProcessor() first.");
+            return false;
+        }
+
+        std::vector<uint8_t> bytes;
+        CheckpointData data;
+        if (!readFile(path, bytes)) {
+            return false;
+        }
+        if (!decodeCheckpoint(bytes, data)) {
+            LOG_ERROR(path + " is not a valid checkpoint");
+            return false;
+        }
+        if (data.processorName != processor->getName()) {
+            LOG_ERROR(path + " holds state of " + data.processorName + ", not " +
+                      processor->getName());
+            return false;
+        }
+        if (data.hasState) {
+            ByteReader state(data.state);
+            if (!processor->restore(state)) {
+                LOG_ERROR(processor->getName() + " could not restore its state");
+                processor->reset();
+                return false;
+            }
+        }
+
+        size_t output = outputQueue_.tryEnqueueBulk(std::make_move_iterator(data.output.begin()),
+                                                    std::make_move_iterator(data.output.end()));
+        size_t keyedOutput = 0;
+        if (keyedOutputQueue_) {
+            keyedOutput = keyedOutputQueue_->tryEnqueueBulk(
+                std::make_move_iterator(data.keyedOutput.begin()),
+                std::make_move_iterator(data.keyedOutput.end()));
+        }
+        size_t lost = data.output.size() - output + data.keyedOutput.size() - keyedOutput;
+        if (lost > 0) {
+            LOG_WARNING(std::to_string(lost) + " restored results did not fit the output queue");
+        }
+
+        restoredPartitions_ = std::move(data.partitions);
+        restoredInput_ = std::move(data.input);
+        LOG_INFO("Checkpoint " + path + " restored: " + std::to_string(restoredInput_.size()) +
+                 " input items, " + std::to_string(output + keyedOutput) + " results, " +
+                 std::to_string(restoredPartitions_.size()) + " partitions");
+        return true;
+    }
+
     // System statistics
     struct Statistics {
         size_t inputQueueSize;
         size_t outputQueueSize;
         size_t totalProcessed;
         size_t totalErrors;
+        size_t totalFiltered; // Items a processor chose to drop
+        size_t totalShed;     // Items dropped by the backpressure policy
+        size_t activeWorkers;
         bool isRunning;
         std::string processorName;
+        uint64_t cacheHits;   // Results served by a CachingProcessor
+        uint64_t cacheMisses;
     };
 
     Statistics getStatistics() const {
-        std::lock_guard<std::mutex> lock(processorMutex_);
+        auto processor = std::atomic_load(&processor_);
+        size_t pendingInput = inputQueue_.size();
+        for (const auto& shard : shards_) {
+            pendingInput += shard->inbox.size();
+        }
+        CacheCounters cache = processor ? processor->cacheCounters() : CacheCounters();
         return {
-            inputQueue_.size(),
-            outputQueue_.size(),
-            totalProcessed_.load(),
-            totalErrors_.load(),
+            pendingInput,
+            outputQueue_.size() + (keyedOutputQueue_ ? keyedOutputQueue_->size() : 0),
+            static_cast<size_t>(totalProcessed_.load()),
+            static_cast<size_t>(totalErrors_.load()),
+            static_cast<size_t>(totalFiltered_.load()),
+            static_cast<size_t>(inputShed_.load()),
+            activeWorkers_.load(),
             isRunning_.load(),
-            processor_ ? processor_->getName() : "None"
+            processor ? processor->getName() : "None",
+            cache.hits,
+            cache.misses
         };
     }
 
+    // Depth, traffic and queue wait of each priority lane; empty while
+    // lanes are not in effect
+    std::vector<LaneStats> getLaneStats() const {
+        if constexpr (kDataQueue) {
+            if (lanesActive_) {
+                return inputQueue_.getStats().lanes;
+            }
+        }
+        return {};
+    }
+
+    // Latency distributions and per-worker counters. Cheap enough to
+    // scrape periodically while the system runs.
+    SystemMetrics getMetrics() const {
+        SystemMetrics metrics;
+        metrics.takenAt = std::chrono::steady_clock::now();
+        metrics.inputTimeouts = inputTimeouts_.load();
+        metrics.inputShed = inputShed_.load();
+        metrics.callerRuns = callerRuns_.load();
+        metrics.activeWorkers = activeWorkers_.load();
+
+        for (size_t i = 0; i < workerMetrics_.size(); ++i) {
+            const WorkerMetrics& source = *workerMetrics_[i];
+            WorkerMetricsSnapshot worker;
+            worker.workerId = i;
+            worker.itemsProcessed = source.itemsProcessed.load();
+            worker.itemsFiltered = source.itemsFiltered.load();
+            worker.batches = source.batches.load();
+            worker.busyNs = source.busyNs.load();
+            worker.idleNs = source.idleNs.load();
+            worker.lockContentions = source.lockContentions.load();
+            worker.outputTimeouts = source.outputTimeouts.load();
+            worker.queueWait = source.queueWait.snapshot();
+            worker.processing = source.processing.snapshot();
+            worker.outputWait = source.outputWait.snapshot();
+            worker.endToEnd = source.endToEnd.snapshot();
+
+            metrics.queueWait.merge(worker.queueWait);
+            metrics.processing.merge(worker.processing);
+            metrics.outputWait.merge(worker.outputWait);
+            metrics.endToEnd.merge(worker.endToEnd);
+            metrics.lockContentions += worker.lockContentions;
+            metrics.outputTimeouts += worker.outputTimeouts;
+            metrics.workers.push_back(std::move(worker));
+        }
+
+        // Items run by producers under CALLER_RUNS count towards the totals
+        metrics.queueWait.merge(callerMetrics_.queueWait.snapshot());
+        metrics.processing.merge(callerMetrics_.processing.snapshot());
+        metrics.outputWait.merge(callerMetrics_.outputWait.snapshot());
+        metrics.endToEnd.merge(callerMetrics_.endToEnd.snapshot());
+        metrics.lockContentions += callerMetrics_.lockContentions.load();
+        metrics.outputTimeouts += callerMetrics_.outputTimeouts.load();
+        return metrics;
+    }
+
     // Print detailed statistics
     void printStatistics() const {
         auto stats = getStatistics();
+        auto metrics = getMetrics();
         LOG_INFO("=== System Statistics ===");
         LOG_INFO("Status: " + std::string(stats.isRunning ? "RUNNING" : "STOPPED"));
         LOG_INFO("Processor: " + stats.processorName);
         LOG_INFO("Input Queue: " + std::to_string(stats.inputQueueSize));
+        auto lanes = getLaneStats();
+        for (size_t i = 0; i < lanes.size(); ++i) {
+            LOG_INFO("Lane " + std::to_string(i) + " (weight " + std::to_string(lanes[i].weight) +
+                     "): " + std::to_string(lanes[i].depth) + "/" +
+                     std::to_string(lanes[i].capacity) + " queued, " +
+                     std::to_string(lanes[i].totalDequeued) + " taken, wait " +
+                     describeLatency(lanes[i].wait));
+        }
         LOG_INFO("Output Queue: " + std::to_string(stats.outputQueueSize));
         LOG_INFO("Total Processed: " + std::to_string(stats.totalProcessed));
         LOG_INFO("Total Errors: " + std::to_string(stats.totalErrors));
+        LOG_INFO("Total Filtered: " + std::to_string(stats.totalFiltered));
+        LOG_INFO("Total Shed: " + std::to_string(stats.totalShed) +
+                 ", Caller Runs: " + std::to_string(metrics.callerRuns));
+        LOG_INFO("Active Workers: " + std::to_string(stats.activeWorkers));
+        if (stats.cacheHits + stats.cacheMisses > 0) {
+            double hitRate = 100.0 * static_cast<double>(stats.cacheHits) /
+                             static_cast<double>(stats.cacheHits + stats.cacheMisses);
+            LOG_INFO("Cache Hits/Misses: " + std::to_string(stats.cacheHits) + "/" +
+                     std::to_string(stats.cacheMisses) + " (" +
+                     std::to_string(static_cast<int>(hitRate + 0.5)) + "% hits)");
+        }
+        LOG_INFO("Queue Wait: " + describeLatency(metrics.queueWait));
+        LOG_INFO("Processing: " + describeLatency(metrics.processing));
+        LOG_INFO("Output Wait: " + describeLatency(metrics.outputWait));
+        LOG_INFO("End-to-End: " + describeLatency(metrics.endToEnd));
+        LOG_INFO("Timeouts (input/output): " + std::to_string(metrics.inputTimeouts) +
+                 "/" + std::to_string(metrics.outputTimeouts) +
+                 ", Lock Contentions: " + std::to_string(metrics.lockContentions));
+        for (const auto& worker : metrics.workers) {
+            std::string cpu = worker.workerId < workerCpus_.size()
+                ? ", cpu " + std::to_string(workerCpus_[worker.workerId]) : "";
+            LOG_INFO("Worker " + std::to_string(worker.workerId) + ": " +
+                     std::to_string(worker.itemsProcessed) + " items, " +
+                     std::to_string(static_cast<int>(worker.utilization() * 100.0 + 0.5)) +
+                     "% busy" + cpu);
+        }
     }
 
 private:
+    // Queue element: the payload plus when it entered the system
+    struct WorkItem {
+        WorkItem() = default;
+
+        template<typename U>
+        WorkItem(U&& payload, int64_t stamp, uint64_t seq = 0)
+            : value(std::forward<U>(payload)), enqueuedNs(stamp), sequence(seq) {}
+
+        template<typename U>
+        WorkItem(U&& payload, int64_t stamp, PartitionKey partition)
+            : value(std::forward<U>(payload)), enqueuedNs(stamp),
+              key(partition.id), keyed(true) {}
+
+        T value;
+        int64_t enqueuedNs = 0;
+        uint64_t sequence = 0; // Assigned in ordered mode only
+        uint64_t key = 0;      // Partitioned mode only
+        bool keyed = false;
+    };
+
+    // Producer-side staging for addBatch()
+    using ItemBuffer = ArenaVector<WorkItem>;
+
+    // Priority lanes and checkpoints of queue contents need the DataQueue backend
+    static constexpr bool kDataQueue = std::is_same<QueueT<WorkItem>, DataQueue<WorkItem>>::value;
+
+    struct WorkerShard;
+
+    // One batch exposed on a work-stealing deque. Whoever runs it hands it
+    // back to its home shard, whose owner refills it, so in steady state
+    // chunks and their item storage are reused instead of reallocated.
+    struct Chunk {
+        std::vector<WorkItem> items;
+        WorkerShard* home = nullptr;
+        Chunk* next = nullptr;
+    };
+
+    // Per-worker state carried from batch to batch
+    struct WorkerContext {
+        size_t workerId;
+        // Worker-local snapshot of the processor, refreshed only when
+        // setProcessor() publishes a new version
+        std::shared_ptr<Processor<T>> processor;
+        uint64_t snapshotVersion = 0;
+        bool serial = true;
+        bool inOrder = true; // Deferred until released in ordered mode
+        std::vector<T> values;
+        std::vector<T> results;
+        std::vector<size_t> dropped;
+        std::vector<uint8_t> keep; // Per-item verdicts of a dropping processor
+        // Ordered mode: sequence number of each batch item, plus buffers
+        // for deferred runs this worker releases
+        std::vector<uint64_t> sequences;
+        std::vector<T> releaseResults;
+        std::vector<size_t> releaseDropped;
+        std::shared_ptr<ResultSink<T>> sink;
+        uint64_t sinkVersion = 0;
+        WorkerMetrics* metrics = nullptr;
+        int64_t idleSince = 0;
+        std::vector<KeyedResult<T>> keyedResults;
+        bool cloneWarned = false;
+    };
+
+    // Input shard for SchedulingMode::WORK_STEALING and PARTITIONED.
+    // Producers fill the inbox. When stealing, the owner splits what it
+    // takes into batches, runs one and pushes the rest onto its deque,
+    // where idle peers can steal them.
+    struct alignas(kCacheLineSize) WorkerShard {
+        explicit WorkerShard(size_t capacity) : inbox(capacity) {}
+
+        ~WorkerShard() {
+            while (auto chunk = deque.pop()) {
+                delete *chunk;
+            }
+            deleteChunks(spare);
+            deleteChunks(returned.load(std::memory_order_acquire));
+        }
+
+        static void deleteChunks(Chunk* chunk) {
+            while (chunk) {
+                Chunk* next = chunk->next;
+                delete chunk;
+                chunk = next;
+            }
+        }
+
+        QueueT<WorkItem> inbox;
+        // Partitioned mode: private processor per owned key, cloned from
+        // processor version partitionVersion. The owner holds the mutex
+        // while it runs one; checkpoint() takes it to read them.
+        std::unordered_map<uint64_t, std::shared_ptr<Processor<T>>> partitions;
+        uint64_t partitionVersion = 0;
+        std::mutex partitionMutex;
+        WorkStealingDeque<Chunk*> deque;
+        std::atomic<Chunk*> returned{nullptr}; // Pushed by any worker
+        Chunk* spare = nullptr;                // Owner only
+    };
+
     void workerThread(size_t workerId) {
         LOG_INFO("Worker thread " + std::to_string(workerId) + " started");
+        if (workerId < workerCpus_.size() && !pinCurrentThread(workerCpus_[workerId])) {
+            LOG_WARNING("Worker " + std::to_string(workerId) + " could not be pinned to cpu " +
+                        std::to_string(workerCpus_[workerId]));
+        }
+
+        WorkerContext context;
+        context.workerId = workerId;
+        context.values.reserve(workerBatchSize_);
+        context.results.reserve(workerBatchSize_);
+        context.metrics = workerMetrics_[workerId].get();
+        context.idleSince = monotonicNanos();
+
+        if (schedulingMode_ == SchedulingMode::WORK_STEALING) {
+            runStealingLoop(context);
+        } else if (schedulingMode_ == SchedulingMode::PARTITIONED) {
+            runPartitionedLoop(context);
+        } else {
+            runSharedQueueLoop(context);
+        }
+        context.metrics->idleNs.add(elapsedNs(context.idleSince, monotonicNanos()));
+
+        LOG_INFO("Worker thread " + std::to_string(workerId) + " finished");
+    }
+
+    void runSharedQueueLoop(WorkerContext& context) {
+        std::vector<WorkItem> batch;
+        batch.reserve(workerBatchSize_);
 
         while (isRunning_.load() || !inputQueue_.empty()) {
-            auto item = inputQueue_.dequeue(500);
-            
-            if (!item) {
+            // Once stopped, parked workers help drain the queue
+            if (isRunning_.load() &&
+                context.workerId >= activeWorkers_.load(std::memory_order_acquire)) {
+                park(context);
                 continue;
             }
+            batch.clear();
+            if (inputQueue_.dequeueBulk(batch, workerBatchSize_) == 0) {
+                continue;
+            }
+            handleBatch(context, batch);
+        }
+    }
 
-            try {
-                std::lock_guard<std::mutex> lock(processorMutex_);
-                
-                if (!processor_) {
-                    LOG_ERROR("Processor not available in worker " + 
-                             std::to_string(workerId));
-                    totalErrors_++;
-                    continue;
-                }
+    // Elastic mode: sleep while the pool is scaled below this worker
+    void park(WorkerContext& context) {
+        std::unique_lock<std::mutex> lock(parkMutex_);
+        parked_.wait(lock, [&] {
+            return context.workerId < activeWorkers_.load() || !isRunning_.load();
+        });
+    }
 
-                T result = processor_->process(item.value());
-                
-                if (outputQueue_.enqueue(result, 500)) {
-                    totalProcessed_++;
-                } else {
-                    LOG_WARNING("Failed to enqueue result in worker " + 
-                               std::to_string(workerId));
-                    totalErrors_++;
+    // Elastic mode: one step per interval. A backlog deeper than a batch
+    // per worker, or busy workers, add a worker; an empty queue with mostly
+    // idle workers for a few intervals in a row parks one. A stateful
+    // processor runs on one worker at a time, so it never grows the pool.
+    void scalerThread() {
+        uint64_t lastBusyNs = totalBusyNs();
+        int64_t lastTick = monotonicNanos();
+        int calmTicks = 0;
+
+        std::unique_lock<std::mutex> lock(scalerMutex_);
+        while (isRunning_.load()) {
+            scalerWake_.wait_for(lock, std::chrono::milliseconds(scaleIntervalMs_),
+                                 [this] { return !isRunning_.load(); });
+            if (!isRunning_.load()) break;
+
+            int64_t now = monotonicNanos();
+            uint64_t busyNs = totalBusyNs();
+            size_t active = activeWorkers_.load();
+            double capacityNs = static_cast<double>(elapsedNs(lastTick, now)) *
+                                static_cast<double>(active);
+            double utilization = capacityNs > 0
+                ? static_cast<double>(busyNs - lastBusyNs) / capacityNs : 0.0;
+            lastBusyNs = busyNs;
+            lastTick = now;
+
+            size_t depth = inputQueue_.size();
+            auto processor = std::atomic_load(&processor_);
+            bool parallel = processor && processor->isStateless();
+
+            if (parallel && active < maxWorkers_ &&
+                (depth > workerBatchSize_ * active || utilization > kScaleUpUtilization)) {
+                resizePool(active + 1);
+                calmTicks = 0;
+            } else if (active > minWorkers_ && depth == 0 && utilization < kScaleDownUtilization) {
+                if (++calmTicks >= kScaleDownTicks) {
+                    resizePool(active - 1);
+                    calmTicks = 0;
                 }
-            } catch (const std::exception& e) {
-                LOG_ERROR("Worker " + std::to_string(workerId) + 
-                         " exception: " + std::string(e.what()));
-                totalErrors_++;
+            } else {
+                calmTicks = 0;
             }
         }
+    }
 
-        LOG_INFO("Worker thread " + std::to_string(workerId) + " finished");
+    // Threads are started on first use and parked, not joined, when the
+    // pool shrinks. Only the scaler calls this while running.
+    void resizePool(size_t target) {
+        size_t previous = activeWorkers_.load();
+        while (workers_.size() < target) {
+            workers_.emplace_back(&ProcessingSystem::workerThread, this, workers_.size());
+        }
+        {
+            std::lock_guard<std::mutex> lock(parkMutex_);
+            activeWorkers_.store(target);
+        }
+        parked_.notify_all();
+        LOG_INFO("Elastic pool: " + std::to_string(previous) + " -> " +
+                 std::to_string(target) + " active workers");
     }
 
-    size_t numWorkers_;
-    DataQueue<T> inputQueue_;
-    DataQueue<T> outputQueue_;
-    
-    std::vector<std::thread> workers_;
-    std::atomic<bool> isRunning_;
-    
-    std::shared_ptr<Processor<T>> processor_;
-    mutable std::mutex processorMutex_;
-    
-    std::atomic<size_t> totalProcessed_;
-    std::atomic<size_t> totalErrors_;
+    uint64_t totalBusyNs() const {
+        uint64_t busy = 0;
+        for (const auto& metrics : workerMetrics_) {
+            busy += metrics->busyNs.load();
+        }
+        return busy;
+    }
+
+    // Partitioned workers only ever read their own inbox, so a key never
+    // leaves its owner
+    void runPartitionedLoop(WorkerContext& context) {
+        WorkerShard& own = *shards_[context.workerId];
+        std::vector<WorkItem> batch;
+        batch.reserve(workerBatchSize_);
+
+        while (isRunning_.load() || !own.inbox.empty()) {
+            batch.clear();
+            if (own.inbox.dequeueBulk(batch, workerBatchSize_) == 0) {
+                continue;
+            }
+            handlePartitionedBatch(context, batch);
+        }
+    }
+
+    void runStealingLoop(WorkerContext& context) {
+        WorkerShard& own = *shards_[context.workerId];
+        std::vector<WorkItem> batch;
+        batch.reserve(workerBatchSize_ * kChunksPerRefill);
+
+        for (;;) {
+            // Read before scanning: once the shards are closed no new input
+            // can arrive, so an empty scan means we are done
+            bool closed = shardsClosed_.load(std::memory_order_acquire);
+
+            if (auto chunk = own.deque.pop()) {
+                runChunk(context, *chunk);
+                continue;
+            }
+            if (!own.inbox.empty() && refillFromInbox(context, own, batch, 1)) {
+                continue;
+            }
+            if (stealFromPeers(context, batch)) {
+                continue;
+            }
+            if (closed) {
+                break;
+            }
+
+            waitForWork();
+        }
+    }
+
+    // Stealing workers sleep here when every shard is empty, and are woken
+    // by whoever makes work visible: a producer filling an inbox, a worker
+    // exposing chunks on its deque, or stop()
+    void waitForWork() {
+        std::unique_lock<std::mutex> lock(idleMutex_);
+        idleWorkers_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        workAvailable_.wait(lock, [this] {
+            return shardsClosed_.load(std::memory_order_acquire) || hasVisibleWork();
+        });
+        idleWorkers_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    bool hasVisibleWork() const {
+        for (const auto& shard : shards_) {
+            if (!shard->deque.empty() || !shard->inbox.empty()) return true;
+        }
+        return false;
+    }
+
+    // Pairs with the fence in waitForWork(): either the sleeper sees the
+    // new work when it rechecks, or we see the sleeper and wake it
+    void wakeIdleWorkers(size_t batches) {
+        if (schedulingMode_ != SchedulingMode::WORK_STEALING || batches == 0) return;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (idleWorkers_.load(std::memory_order_relaxed) == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(idleMutex_);
+        }
+        if (batches == 1) {
+            workAvailable_.notify_one();
+        } else {
+            workAvailable_.notify_all();
+        }
+    }
+
+    // Take several batches' worth from the inbox, expose all but the first
+    // on the deque and process the first one right away
+    bool refillFromInbox(WorkerContext& context, WorkerShard& shard,
+                         std::vector<WorkItem>& batch, int waitMs) {
+        batch.clear();
+        size_t taken = shard.inbox.dequeueBulk(batch, workerBatchSize_ * kChunksPerRefill, waitMs);
+        if (taken == 0) {
+            return false;
+        }
+
+        size_t exposed = 0;
+        for (size_t begin = workerBatchSize_; begin < taken; begin += workerBatchSize_) {
+            size_t end = std::min(begin + workerBatchSize_, taken);
+            Chunk* chunk = takeChunk(shard);
+            chunk->items.assign(std::make_move_iterator(batch.begin() + begin),
+                                std::make_move_iterator(batch.begin() + end));
+            shard.deque.push(chunk);
+            ++exposed;
+        }
+        wakeIdleWorkers(exposed);
+        batch.resize(std::min(taken, workerBatchSize_));
+        handleBatch(context, batch);
+        return true;
+    }
+
+    bool stealFromPeers(WorkerContext& context, std::vector<WorkItem>& batch) {
+        const std::vector<size_t>& peers = stealOrder_[context.workerId];
+        for (size_t peerId : peers) {
+            if (auto chunk = shards_[peerId]->deque.steal()) {
+                runChunk(context, *chunk);
+                return true;
+            }
+        }
+        // Nothing split yet: help with peers' unclaimed inbox backlog
+        for (size_t peerId : peers) {
+            WorkerShard& peer = *shards_[peerId];
+            if (peer.inbox.empty()) {
+                continue;
+            }
+            batch.clear();
+            if (peer.inbox.dequeueBulk(batch, workerBatchSize_, 1) > 0) {
+                handleBatch(context, batch);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void runChunk(WorkerContext& context, Chunk* chunk) {
+        handleBatch(context, chunk->items);
+        chunk->items.clear();
+        returnChunk(chunk);
+    }
+
+    // Owner side: reuse a returned chunk, collecting the returned list
+    // in one exchange when the private spare list runs dry
+    Chunk* takeChunk(WorkerShard& shard) {
+        if (!shard.spare) {
+            shard.spare = shard.returned.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (!shard.spare) {
+            Chunk* chunk = new Chunk;
+            chunk->home = &shard;
+            return chunk;
+        }
+        Chunk* chunk = shard.spare;
+        shard.spare = chunk->next;
+        return chunk;
+    }
+
+    // Only the owner ever removes from returned, and it takes the whole
+    // list at once, so this push cannot suffer from ABA
+    static void returnChunk(Chunk* chunk) {
+        std::atomic<Chunk*>& returned = chunk->home->returned;
+        Chunk* head = returned.load(std::memory_order_relaxed);
+        do {
+            chunk->next = head;
+        } while (!returned.compare_exchange_weak(head, chunk, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    }
+
+    size_t pickShard() {
+        const std::vector<size_t>* local = localShards();
+        size_t count = local ? local->size() : shards_.size();
+        size_t slot;
+        if (distributionPolicy_ == DistributionPolicy::THREAD_AFFINITY) {
+            slot = std::hash<std::thread::id>()(std::this_thread::get_id()) % count;
+        } else {
+            slot = nextShard_.fetch_add(1, std::memory_order_relaxed) % count;
+        }
+        return local ? (*local)[slot] : slot;
+    }
+
+    // Shards of the workers on the calling thread's NUMA node, or nullptr
+    // to pick among all shards
+    const std::vector<size_t>* localShards() const {
+        if (nodeShards_.size() < 2) {
+            return nullptr;
+        }
+        int cpu = currentCpu();
+        if (cpu < 0) {
+            return nullptr;
+        }
+        const std::vector<size_t>& local = nodeShards_[topology_.nodeIndexOf(cpu)];
+        return local.empty() ? nullptr : &local;
+    }
+
+    // Group shards by their worker's node, and order each worker's steal
+    // victims nearest first: same-node peers, then the rest, each group
+    // starting after the worker itself
+    void mapShardsToNodes() {
+        size_t count = shards_.size();
+        auto nodeOf = [this](size_t worker) {
+            return worker < workerCpus_.size() ? topology_.nodeIndexOf(workerCpus_[worker]) : 0;
+        };
+        nodeShards_.clear();
+        if (!workerCpus_.empty()) {
+            nodeShards_.resize(topology_.nodes().size());
+            for (size_t i = 0; i < count; ++i) {
+                nodeShards_[nodeOf(i)].push_back(i);
+            }
+        }
+        stealOrder_.assign(count, {});
+        for (size_t i = 0; i < count; ++i) {
+            std::vector<size_t> remote;
+            for (size_t offset = 1; offset < count; ++offset) {
+                size_t peer = (i + offset) % count;
+                (nodeOf(peer) == nodeOf(i) ? stealOrder_[i] : remote).push_back(peer);
+            }
+            stealOrder_[i].insert(stealOrder_[i].end(), remote.begin(), remote.end());
+        }
+    }
+
+    // Owner of a key; the mix spreads sequential ids over all workers
+    size_t shardForKey(PartitionKey key) const {
+        return static_cast<size_t>(partitionHash(key) % shards_.size());
+    }
+
+    bool usesShards() const {
+        return schedulingMode_ != SchedulingMode::SHARED_QUEUE;
+    }
+
+    // Pick up a processor published by setProcessor(). Returns true if the
+    // snapshot changed.
+    bool refreshProcessor(WorkerContext& context) {
+        uint64_t version = processorVersion_.load(std::memory_order_acquire);
+        if (context.processor && version == context.snapshotVersion) {
+            return false;
+        }
+        context.processor = std::atomic_load(&processor_);
+        context.snapshotVersion = version;
+        context.serial = context.processor && !context.processor->isStateless();
+        context.inOrder = context.processor && context.processor->needsInputOrder();
+        return true;
+    }
+
+    // Process a batch the worker owns and deliver the results. Items are
+    // moved, never copied, on the way out.
+    void handleBatch(WorkerContext& context, std::vector<WorkItem>& batch) {
+        WorkerMetrics& metrics = *context.metrics;
+        int64_t pickedUp = monotonicNanos();
+        metrics.idleNs.add(elapsedNs(context.idleSince, pickedUp));
+
+        refreshProcessor(context);
+
+        auto& values = context.values;
+        auto& results = context.results;
+        auto& dropped = context.dropped;
+        values.clear();
+        results.clear();
+        dropped.clear();
+        if (reorder_) {
+            context.sequences.clear();
+            for (const auto& item : batch) {
+                context.sequences.push_back(item.sequence);
+            }
+        }
+
+        if (!context.processor) {
+            LOG_ERROR("Processor not available in worker " + 
+                     std::to_string(context.workerId));
+            totalErrors_.addAt(context.workerId, batch.size());
+            if (reorder_) {
+                // Keep the sequence dense so later results are not held up
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    dropped.push_back(i);
+                }
+                insertOrdered(context, false);
+            }
+            context.idleSince = monotonicNanos();
+            settle(batch.size());
+            return;
+        }
+
+        for (auto& item : batch) {
+            metrics.queueWait.record(elapsedNs(item.enqueuedNs, pickedUp));
+            values.push_back(std::move(item.value));
+        }
+
+        // In ordered mode a stateful processor must also see items in
+        // order, so it runs when the reorder buffer releases them
+        bool deferred = reorder_ && context.inOrder;
+        if (deferred) {
+            results.swap(values);
+        } else {
+            runProcessor(context, values, results, dropped);
+        }
+        int64_t processed = monotonicNanos();
+
+        if (reorder_) {
+            insertOrdered(context, deferred);
+        } else {
+            deliver(context, results);
+        }
+        int64_t finished = monotonicNanos();
+
+        metrics.processing.record(elapsedNs(pickedUp, processed) / batch.size(), batch.size());
+        metrics.outputWait.record(elapsedNs(processed, finished));
+        for (const auto& item : batch) {
+            metrics.endToEnd.record(elapsedNs(item.enqueuedNs, finished));
+        }
+        metrics.batches.add();
+        metrics.busyNs.add(elapsedNs(pickedUp, finished));
+        context.idleSince = finished;
+        settle(batch.size());
+    }
+
+    // SchedulingMode::PARTITIONED: each run of items with the same key goes
+    // through that key's private processor; unkeyed items use the shared one
+    void handlePartitionedBatch(WorkerContext& context, std::vector<WorkItem>& batch) {
+        WorkerMetrics& metrics = *context.metrics;
+        int64_t pickedUp = monotonicNanos();
+        metrics.idleNs.add(elapsedNs(context.idleSince, pickedUp));
+
+        refreshProcessor(context);
+        if (!context.processor) {
+            LOG_ERROR("Processor not available in worker " + 
+                     std::to_string(context.workerId));
+            totalErrors_.addAt(context.workerId, batch.size());
+            context.idleSince = monotonicNanos();
+            settle(batch.size());
+            return;
+        }
+        WorkerShard& own = *shards_[context.workerId];
+        if (own.partitionVersion != context.snapshotVersion) {
+            // New processor: partitions start over from it
+            std::lock_guard<std::mutex> lock(own.partitionMutex);
+            own.partitions.clear();
+            own.partitionVersion = context.snapshotVersion;
+        }
+
+        auto& values = context.values;
+        auto& results = context.results;
+        auto& dropped = context.dropped;
+        uint64_t processingNs = 0;
+        for (size_t begin = 0; begin < batch.size();) {
+            const WorkItem& head = batch[begin];
+            size_t end = begin + 1;
+            while (end < batch.size() && batch[end].keyed == head.keyed &&
+                   batch[end].key == head.key) {
+                ++end;
+            }
+
+            values.clear();
+            for (size_t i = begin; i < end; ++i) {
+                metrics.queueWait.record(elapsedNs(batch[i].enqueuedNs, pickedUp));
+                values.push_back(std::move(batch[i].value));
+            }
+
+            int64_t runStart = monotonicNanos();
+            if (head.keyed) {
+                std::unique_lock<std::mutex> lock(own.partitionMutex);
+                Processor<T>* partition = partitionFor(context, own, head.key);
+                if (partition) {
+                    runProcessor(context, *partition, false, values, results, dropped);
+                } else {
+                    runProcessor(context, values, results, dropped);
+                }
+                lock.unlock();
+                processingNs += elapsedNs(runStart, monotonicNanos());
+                deliverKeyed(context, PartitionKey(head.key), results);
+            } else {
+                runProcessor(context, values, results, dropped);
+                processingNs += elapsedNs(runStart, monotonicNanos());
+                deliver(context, results);
+            }
+            begin = end;
+        }
+        int64_t finished = monotonicNanos();
+
+        uint64_t totalNs = elapsedNs(pickedUp, finished);
+        metrics.processing.record(processingNs / batch.size(), batch.size());
+        metrics.outputWait.record(totalNs > processingNs ? totalNs - processingNs : 0);
+        for (const auto& item : batch) {
+            metrics.endToEnd.record(elapsedNs(item.enqueuedNs, finished));
+        }
+        metrics.batches.add();
+        metrics.busyNs.add(totalNs);
+        context.idleSince = finished;
+        settle(batch.size());
+    }
+
+    // The key's private processor, cloned from the shared one on first use.
+    // Null if the processor cannot be cloned. Needs shard.partitionMutex.
+    Processor<T>* partitionFor(WorkerContext& context, WorkerShard& shard, uint64_t key) {
+        auto it = shard.partitions.find(key);
+        if (it != shard.partitions.end()) {
+            return it->second.get();
+        }
+        auto instance = context.processor->clone();
+        if (!instance) {
+            if (!context.cloneWarned) {
+                LOG_WARNING(context.processor->getName() +
+                            " cannot be cloned; partitions share one instance");
+                context.cloneWarned = true;
+            }
+            return nullptr;
+        }
+        return shard.partitions.emplace(key, std::move(instance)).first->second.get();
+    }
+
+    // Items leave the in-flight count once their batch has been delivered
+    // (or, in ordered mode, inserted: a batch held back in the reorder
+    // buffer waits for an earlier one that is still counted, and whoever
+    // completes the gap releases both before settling)
+    void settle(size_t count) {
+        if (count == 0) return;
+        if (inFlight_.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            {
+                std::lock_guard<std::mutex> lock(drainMutex_);
+            }
+            drained_.notify_all();
+        }
+    }
+
+    // Run the worker's processor over input. The output ends up in results
+    // and the indices of items that produced none in dropped.
+    void runProcessor(WorkerContext& context, std::vector<T>& input,
+                      std::vector<T>& results, std::vector<size_t>& dropped) {
+        runProcessor(context, *context.processor, context.serial, input, results, dropped);
+    }
+
+    void runProcessor(WorkerContext& context, Processor<T>& processor, bool serial,
+                      std::vector<T>& input, std::vector<T>& results,
+                      std::vector<size_t>& dropped) {
+        results.clear();
+        dropped.clear();
+        bool filters = processor.dropsItems();
+        bool inPlace = !filters && processor.processesInPlace();
+        std::unique_lock<std::mutex> lock;
+        if (serial) {
+            // Stateful processors are not safe to share, so only one
+            // worker runs them; the lock is taken once per batch
+            lock = std::unique_lock<std::mutex>(serialMutex_, std::try_to_lock);
+            if (!lock.owns_lock()) {
+                context.metrics->lockContentions.add();
+                lock.lock();
+            }
+        }
+        if (filters) {
+            processFiltered(context, processor, input, results, dropped);
+        } else if (inPlace) {
+            processInPlace(processor, input, dropped, context.workerId);
+            results.swap(input);
+        } else {
+            processBatch(processor, input, results, dropped, context.workerId);
+        }
+    }
+
+    // Hand the batch to the reorder buffer. Whichever worker completes the
+    // run at the release point delivers it, finishing deferred items first.
+    void insertOrdered(WorkerContext& context, bool deferred) {
+        reorder_->insert(context.sequences, context.dropped, context.results, deferred,
+            [&](std::vector<T>& run, bool runDeferred) {
+                if (!runDeferred) {
+                    deliver(context, run);
+                    return;
+                }
+                if (!context.processor) {
+                    totalErrors_.addAt(context.workerId, run.size());
+                    return;
+                }
+                runProcessor(context, run, context.releaseResults, context.releaseDropped);
+                deliver(context, context.releaseResults);
+            });
+    }
+
+    // Move results into the downstream system, the sink or the output queue
+    size_t deliver(WorkerContext& context, std::vector<T>& results) {
+        size_t produced = results.size();
+        ProcessingSystem* downstream = downstream_.load(std::memory_order_acquire);
+        size_t delivered;
+        if (downstream) {
+            delivered = downstream->addBatch(std::move(results), 500);
+        } else if (ResultSink<T>* sink = refreshSink(context)) {
+            delivered = sink->deliver(results);
+        } else {
+            delivered = outputQueue_.enqueueBulk(std::move(results), 500);
+        }
+        accountDelivery(context, produced, delivered);
+        results.clear();
+        return delivered;
+    }
+
+    // Keyed results keep their key: a partitioned downstream routes them
+    // to the key's owner there, otherwise they go to the keyed output queue
+    size_t deliverKeyed(WorkerContext& context, PartitionKey key, std::vector<T>& results) {
+        size_t produced = results.size();
+        size_t delivered;
+        ProcessingSystem* downstream = downstream_.load(std::memory_order_acquire);
+        if (downstream) {
+            delivered = downstream->schedulingMode_ == SchedulingMode::PARTITIONED
+                ? downstream->addBatch(key, std::move(results), 500)
+                : downstream->addBatch(std::move(results), 500);
+        } else if (ResultSink<T>* sink = refreshSink(context)) {
+            delivered = sink->deliverKeyed(key, results);
+        } else {
+            auto& keyed = context.keyedResults;
+            keyed.clear();
+            for (auto& value : results) {
+                keyed.push_back(KeyedResult<T>{key, std::move(value)});
+            }
+            delivered = keyedOutputQueue_->enqueueBulk(std::move(keyed), 500);
+        }
+        accountDelivery(context, produced, delivered);
+        results.clear();
+        return delivered;
+    }
+
+    // Worker-local sink snapshot, refreshed only when setResultSink()
+    // publishes a new one
+    ResultSink<T>* refreshSink(WorkerContext& context) {
+        uint64_t version = sinkVersion_.load(std::memory_order_acquire);
+        if (version != context.sinkVersion) {
+            context.sink = std::atomic_load(&sink_);
+            context.sinkVersion = version;
+        }
+        return context.sink.get();
+    }
+
+    void accountDelivery(WorkerContext& context, size_t produced, size_t delivered) {
+        totalProcessed_.addAt(context.workerId, delivered);
+        context.metrics->itemsProcessed.add(delivered);
+        if (delivered < produced) {
+            LOG_WARNING("Failed to enqueue " + std::to_string(produced - delivered) +
+                       " results in worker " + std::to_string(context.workerId));
+            totalErrors_.addAt(context.workerId, produced - delivered);
+            context.metrics->outputTimeouts.add(produced - delivered);
+        }
+    }
+
+    // Run the whole batch through the processor's batch kernel. If it throws,
+    // fall back to per-item processing so one bad item only costs itself.
+    // A kernel may have applied some items before throwing, so processors
+    // that cannot take an item twice go item by item from the start.
+    void processBatch(Processor<T>& processor, const std::vector<T>& batch,
+                      std::vector<T>& results, std::vector<size_t>& dropped,
+                      size_t workerId) {
+        if (processor.canRetryBatch()) {
+            try {
+                results.resize(batch.size());
+                processor.processBatch(batch.data(), results.data(), batch.size());
+                return;
+            } catch (const std::exception&) {
+                results.clear();
+            }
+        }
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            try {
+                results.push_back(processor.process(batch[i]));
+            } catch (const std::exception& e) {
+                LOG_ERROR("Worker " + std::to_string(workerId) + 
+                         " exception: " + std::string(e.what()));
+                totalErrors_.addAt(workerId);
+                dropped.push_back(i);
+            }
+        }
+    }
+
+    // Like processBatch() for processors that drop items: the batch kernel
+    // compacts the kept results, and the dropped indices are recovered from
+    // its verdicts for the reorder buffer. Filtered items are not errors.
+    void processFiltered(WorkerContext& context, Processor<T>& processor,
+                         const std::vector<T>& batch, std::vector<T>& results,
+                         std::vector<size_t>& dropped) {
+        size_t n = batch.size();
+        size_t filtered = 0;
+        bool batched = false;
+        if (processor.canRetryBatch()) {
+            try {
+                results.resize(n);
+                context.keep.resize(n);
+                size_t kept = processor.processBatchFiltered(batch.data(), results.data(),
+                                                             context.keep.data(), n);
+                results.resize(kept);
+                if (kept < n) {
+                    for (size_t i = 0; i < n; ++i) {
+                        if (!context.keep[i]) dropped.push_back(i);
+                    }
+                }
+                filtered = n - kept;
+                batched = true;
+            } catch (const std::exception&) {
+                results.clear();
+                dropped.clear();
+            }
+        }
+        if (!batched) {
+            for (size_t i = 0; i < n; ++i) {
+                try {
+                    std::optional<T> result = processor.tryProcess(batch[i]);
+                    if (result) {
+                        results.push_back(std::move(*result));
+                        continue;
+                    }
+                    ++filtered;
+                } catch (const std::exception& e) {
+                    LOG_ERROR("Worker " + std::to_string(context.workerId) + 
+                             " exception: " + std::string(e.what()));
+                    totalErrors_.addAt(context.workerId);
+                }
+                dropped.push_back(i);
+            }
+        }
+        if (filtered) {
+            totalFiltered_.addAt(context.workerId, filtered);
+            context.metrics->itemsFiltered.add(filtered);
+        }
+    }
+
+    // Transform the batch where it lies; items that throw are dropped
+    void processInPlace(Processor<T>& processor, std::vector<T>& batch,
+                        std::vector<size_t>& dropped, size_t workerId) {
+        size_t kept = 0;
+        for (size_t i = 0; i < batch.size(); ++i) {
+            try {
+                processor.processInPlace(batch[i]);
+                if (kept != i) {
+                    batch[kept] = std::move(batch[i]);
+                }
+                ++kept;
+            } catch (const std::exception& e) {
+                LOG_ERROR("Worker " + std::to_string(workerId) + 
+                         " exception: " + std::string(e.what()));
+                totalErrors_.addAt(workerId);
+                dropped.push_back(i);
+            }
+        }
+        batch.resize(kept);
+    }
+
+    template<typename U>
+    bool submit(U&& data, int timeoutMs, size_t lane = 0) {
+        if (!isRunning_) {
+            LOG_WARNING("System not running. Cannot add data.");
+            return false;
+        }
+        if (orderedOutput_) {
+            // Numbering and enqueueing under one lock keeps queue order
+            // and sequence order identical, so no number is ever left
+            // waiting behind a producer blocked on a full queue
+            std::lock_guard<std::mutex> lock(sequenceMutex_);
+            if (admit(inputQueue_, timeoutMs, std::forward<U>(data),
+                      monotonicNanos(), nextSequence_)) {
+                ++nextSequence_;
+                return true;
+            }
+            return false;
+        }
+
+        if (!usesShards()) {
+            return withInputLane(lane, [&](auto& queue) {
+                return admit(queue, timeoutMs, std::forward<U>(data), monotonicNanos());
+            });
+        }
+        bool added = admit(shards_[pickShard()]->inbox, timeoutMs, std::forward<U>(data),
+                           monotonicNanos());
+        wakeIdleWorkers(added ? 1 : 0);
+        return added;
+    }
+
+    template<typename U>
+    bool submitKeyed(PartitionKey key, U&& data, int timeoutMs) {
+        if (!isRunning_) {
+            LOG_WARNING("System not running. Cannot add data.");
+            return false;
+        }
+        if (schedulingMode_ != SchedulingMode::PARTITIONED) {
+            LOG_WARNING("Keyed data needs SchedulingMode::PARTITIONED");
+            return false;
+        }
+        return admit(shards_[shardForKey(key)]->inbox, timeoutMs, std::forward<U>(data),
+                     monotonicNanos(), key);
+    }
+
+    template<typename InputIt>
+    size_t submitKeyedBatch(PartitionKey key, InputIt first, InputIt last, int timeoutMs) {
+        if (!isRunning_) {
+            LOG_WARNING("System not running. Cannot add data.");
+            return 0;
+        }
+        if (schedulingMode_ != SchedulingMode::PARTITIONED) {
+            LOG_WARNING("Keyed data needs SchedulingMode::PARTITIONED");
+            return 0;
+        }
+
+        ScratchScope scratch;
+        ItemBuffer items(scratch.allocator<WorkItem>());
+        items.reserve(static_cast<size_t>(std::distance(first, last)));
+        int64_t now = monotonicNanos();
+        for (; first != last; ++first) {
+            items.emplace_back(*first, now, key);
+        }
+        return admitBulk(shards_[shardForKey(key)]->inbox, items, 0, items.size(), timeoutMs);
+    }
+
+    // Hand stamped items to the input queue, or in work-stealing mode one
+    // worker-sized slice per shard. Returns how many were accepted.
+    size_t enqueueItems(ItemBuffer& items, int timeoutMs, size_t lane = 0) {
+        if (orderedOutput_) {
+            std::lock_guard<std::mutex> lock(sequenceMutex_);
+            for (size_t i = 0; i < items.size(); ++i) {
+                items[i].sequence = nextSequence_ + i;
+            }
+            size_t added = admitBulk(inputQueue_, items, 0, items.size(), timeoutMs);
+            nextSequence_ += added;
+            return added;
+        }
+        if (!usesShards()) {
+            return withInputLane(lane, [&](auto& queue) {
+                return admitBulk(queue, items, 0, items.size(), timeoutMs);
+            });
+        }
+
+        size_t added = 0;
+        for (size_t begin = 0; begin < items.size(); begin += workerBatchSize_) {
+            size_t end = std::min(begin + workerBatchSize_, items.size());
+            size_t accepted = admitBulk(shards_[pickShard()]->inbox, items, begin, end, timeoutMs);
+            added += accepted;
+            // Wake a sleeper per slice, not once at the end: the next
+            // slice may block on a full inbox that only they can empty
+            wakeIdleWorkers(accepted > 0 ? 1 : 0);
+            if (accepted < end - begin && backpressure_ == BackpressurePolicy::BLOCK) {
+                inputTimeouts_ += items.size() - end; // Not offered once one shard timed out
+                break;
+            }
+        }
+        return added;
+    }
+
+    // Offer one item to queue under the backpressure policy
+    // Items are counted in flight before they become visible to workers,
+    // so the count can never reach zero while one is still queued
+    template<typename Queue, typename... Args>
+    bool admit(Queue& queue, int timeoutMs, Args&&... args) {
+        inFlight_.fetch_add(1, std::memory_order_relaxed);
+        if (backpressure_ == BackpressurePolicy::BLOCK) {
+            if (queue.emplaceFor(timeoutMs, std::forward<Args>(args)...)) {
+                return true;
+            }
+            ++inputTimeouts_;
+            settle(1);
+            return false;
+        }
+
+        WorkItem item(std::forward<Args>(args)...);
+        if (queue.tryEnqueue(std::move(item))) { // Only moved from on success
+            return true;
+        }
+        switch (backpressure_) {
+            case BackpressurePolicy::DROP_OLDEST:
+                if (enqueueEvicting(queue, item)) {
+                    return true;
+                }
+                settle(1);
+                return false;
+            case BackpressurePolicy::CALLER_RUNS:
+                if (!item.keyed) {
+                    runOnCaller(&item, 1);
+                    return true;
+                }
+                if (queue.enqueue(std::move(item), timeoutMs)) {
+                    return true;
+                }
+                ++inputTimeouts_;
+                settle(1);
+                return false;
+            default:
+                ++inputShed_;
+                settle(1);
+                return false;
+        }
+    }
+
+    // Bulk form of admit() for items[begin, end). Returns how many were
+    // taken, counting those run on the caller; the accepted ones are
+    // always a prefix, which keeps ordered-mode numbering dense.
+    template<typename Queue>
+    size_t admitBulk(Queue& queue, ItemBuffer& items,
+                     size_t begin, size_t end, int timeoutMs) {
+        auto first = std::make_move_iterator(items.begin() + begin);
+        auto last = std::make_move_iterator(items.begin() + end);
+        inFlight_.fetch_add(end - begin, std::memory_order_relaxed);
+        if (backpressure_ == BackpressurePolicy::BLOCK) {
+            size_t added = queue.enqueueBulk(first, last, timeoutMs);
+            inputTimeouts_ += (end - begin) - added;
+            settle((end - begin) - added);
+            return added;
+        }
+
+        size_t added = queue.tryEnqueueBulk(first, last);
+        size_t rest = begin + added;
+        if (rest == end) {
+            return added;
+        }
+        switch (backpressure_) {
+            case BackpressurePolicy::DROP_OLDEST:
+                for (; rest < end && enqueueEvicting(queue, items[rest]); ++rest) {
+                    ++added;
+                }
+                settle(end - rest); // Refused after shutdown
+                return added;
+            case BackpressurePolicy::CALLER_RUNS: {
+                if (!items[begin].keyed) {
+                    runOnCaller(items.data() + rest, end - rest);
+                    return end - begin;
+                }
+                size_t waited = queue.enqueueBulk(std::make_move_iterator(items.begin() + rest),
+                                                  last, timeoutMs);
+                inputTimeouts_ += (end - rest) - waited;
+                settle((end - rest) - waited);
+                return added + waited;
+            }
+            default:
+                inputShed_ += end - rest;
+                settle(end - rest);
+                return added;
+        }
+    }
+
+    // DROP_OLDEST: discard queued items until item fits
+    template<typename Queue>
+    bool enqueueEvicting(Queue& queue, WorkItem& item) {
+        while (!queue.tryEnqueue(std::move(item))) {
+            if (queue.isShutdown()) {
+                ++inputShed_;
+                return false; // The caller settles it
+            }
+            if (auto oldest = queue.tryDequeue()) {
+                discardEvicted(*oldest);
+            }
+        }
+        return true;
+    }
+
+    // Call fn with the input queue, or with one lane of it while priority
+    // lanes are in effect. A full lane evicts (DROP_OLDEST) only its own.
+    template<typename Fn>
+    auto withInputLane(size_t lane, Fn&& fn) {
+        if constexpr (kDataQueue) {
+            if (lanesActive_ && lane > 0) {
+                auto view = inputQueue_.lane(lane);
+                return fn(view);
+            }
+        }
+        return fn(inputQueue_);
+    }
+
+    bool isLane(size_t lane) const {
+        if (lane < std::max<size_t>(inputLanes_.size(), 1)) {
+            return true;
+        }
+        LOG_ERROR("No priority lane " + std::to_string(lane));
+        return false;
+    }
+
+    // At start(): lay the still empty input queue out as configured
+    void configureInputLanes() {
+        lanesActive_ = false;
+        if constexpr (kDataQueue) {
+            if (inputLanes_.size() > 1) {
+                if (usesShards() || orderedOutput_) {
+                    LOG_WARNING("Priority lanes need the shared input queue without ordered output; "
+                                "lanes ignored");
+                } else {
+                    lanesActive_ = inputQueue_.configureLanes(inputLanes_);
+                }
+            }
+            if (!lanesActive_) {
+                inputQueue_.configureLanes({LaneConfig{queueSize_, 1}});
+            }
+        }
+    }
+
+    // What checkpoint() captures, in file order
+    struct CheckpointData {
+        std::string processorName;
+        bool hasState = false;
+        std::vector<uint8_t> state;
+        std::vector<std::pair<uint64_t, std::vector<uint8_t>>> partitions;
+        std::vector<WorkItem> input;
+        std::vector<T> output;
+        std::vector<KeyedResult<T>> keyedOutput;
+    };
+
+    // Magic, the sections in order (counts and keys as varints, states as
+    // blobs), then a checksum of everything before it
+    static std::vector<uint8_t> encodeCheckpoint(const CheckpointData& data) {
+        ByteWriter out;
+        out.writeBytes(kCheckpointMagic, sizeof(kCheckpointMagic));
+        out.write(data.processorName);
+        out.write(data.hasState);
+        out.writeBlob(data.state);
+        out.writeVarint(data.partitions.size());
+        for (const auto& [key, state] : data.partitions) {
+            out.writeVarint(key);
+            out.writeBlob(state);
+        }
+        out.writeVarint(data.input.size());
+        for (const auto& item : data.input) {
+            out.write(item.keyed);
+            if (item.keyed) out.writeVarint(item.key);
+            out.write(item.value);
+        }
+        out.write(data.output);
+        out.writeVarint(data.keyedOutput.size());
+        for (const auto& result : data.keyedOutput) {
+            out.writeVarint(result.key.id);
+            out.write(result.value);
+        }
+        out.write(checksum64(out.bytes().data(), out.size()));
+        return std::move(out.bytes());
+    }
+
+    static bool decodeCheckpoint(const std::vector<uint8_t>& bytes, CheckpointData& data) {
+        uint64_t sum;
+        if (bytes.size() < sizeof(kCheckpointMagic) + sizeof(sum) ||
+            std::memcmp(bytes.data(), kCheckpointMagic, sizeof(kCheckpointMagic)) != 0) {
+            return false;
+        }
+        size_t body = bytes.size() - sizeof(sum);
+        std::memcpy(&sum, bytes.data() + body, sizeof(sum));
+        if (sum != checksum64(bytes.data(), body)) {
+            return false;
+        }
+
+        ByteReader in(bytes.data() + sizeof(kCheckpointMagic), body - sizeof(kCheckpointMagic));
+        uint64_t count;
+        in.read(data.processorName);
+        in.read(data.hasState);
+        in.readBlob(data.state);
+        if (in.readCount(count)) {
+            for (uint64_t i = 0; i < count && !in.failed(); ++i) {
+                uint64_t key;
+                std::vector<uint8_t> state;
+                if (in.readVarint(key) && in.readBlob(state)) {
+                    data.partitions.emplace_back(key, std::move(state));
+                }
+            }
+        }
+        if (in.readCount(count)) {
+            for (uint64_t i = 0; i < count && !in.failed(); ++i) {
+                WorkItem item;
+                if (in.read(item.keyed) && (!item.keyed || in.readVarint(item.key)) &&
+                    in.read(item.value)) {
+                    data.input.push_back(std::move(item));
+                }
+            }
+        }
+        in.read(data.output);
+        if (in.readCount(count)) {
+            for (uint64_t i = 0; i < count && !in.failed(); ++i) {
+                KeyedResult<T> result;
+                if (in.readVarint(result.key.id) && in.read(result.value)) {
+                    data.keyedOutput.push_back(std::move(result));
+                }
+            }
+        }
+        return !in.failed() && in.atEnd();
+    }
+
+    // start(): hand restored partitions to the shards owning their keys
+    void installRestoredPartitions() {
+        if (restoredPartitions_.empty()) return;
+        if (schedulingMode_ != SchedulingMode::PARTITIONED) {
+            LOG_WARNING("Restored partitions ignored: not in partitioned mode");
+            restoredPartitions_.clear();
+            return;
+        }
+        auto processor = std::atomic_load(&processor_);
+        uint64_t version = processorVersion_.load(std::memory_order_acquire);
+        for (auto& [key, state] : restoredPartitions_) {
+            auto instance = processor->clone();
+            ByteReader reader(state);
+            if (!instance || !instance->restore(reader)) {
+                LOG_ERROR("Cannot restore partition " + std::to_string(key));
+                continue;
+            }
+            WorkerShard& shard = *shards_[shardForKey(PartitionKey(key))];
+            shard.partitions.emplace(key, std::move(instance));
+            shard.partitionVersion = version;
+        }
+        restoredPartitions_.clear();
+    }
+
+    // start(): requeue restored input, waiting for room as needed
+    void requeueRestoredInput() {
+        if (restoredInput_.empty()) return;
+        std::vector<WorkItem> items = std::move(restoredInput_);
+        restoredInput_.clear();
+        size_t requeued = 0;
+        for (auto& item : items) {
+            bool added = item.keyed && schedulingMode_ == SchedulingMode::PARTITIONED
+                ? submitKeyed(PartitionKey(item.key), std::move(item.value), -1)
+                : submit(std::move(item.value), -1);
+            requeued += added ? 1 : 0;
+        }
+        LOG_INFO("Requeued " + std::to_string(requeued) + " items from checkpoint");
+    }
+
+    // In ordered mode an evicted item's sequence number is released as
+    // dropped, or every later result would wait for it
+    void discardEvicted(const WorkItem& item) {
+        ++inputShed_;
+        if (reorder_) {
+            std::lock_guard<std::mutex> lock(callerMutex_);
+            WorkerContext& context = callerContext_;
+            refreshProcessor(context);
+            context.sequences.assign(1, item.sequence);
+            context.dropped.assign(1, 0);
+            context.results.clear();
+            insertOrdered(context, false);
+        }
+        settle(1);
+    }
+
+    // CALLER_RUNS: process overflow on the producer's thread, one worker
+    // batch at a time. Producers take turns, so together they add at most
+    // one worker's worth of throughput while they are held up.
+    void runOnCaller(WorkItem* items, size_t count) {
+        std::lock_guard<std::mutex> lock(callerMutex_);
+        for (size_t begin = 0; begin < count; begin += workerBatchSize_) {
+            size_t end = std::min(begin + workerBatchSize_, count);
+            callerBatch_.assign(std::make_move_iterator(items + begin),
+                                std::make_move_iterator(items + end));
+            callerContext_.idleSince = monotonicNanos();
+            handleBatch(callerContext_, callerBatch_);
+        }
+        callerRuns_ += count;
+    }
+
+    static uint64_t elapsedNs(int64_t from, int64_t to) {
+        return to > from ? static_cast<uint64_t>(to - from) : 0;
+    }
+
+    // e.g. "p50 12.5us p99 80.1us max 310.0us (n=10000)"
+    static std::string describeLatency(const LatencyHistogram::Snapshot& histogram) {
+        char buffer[128];
+        std::snprintf(buffer, sizeof(buffer), "p50 %.1fus p99 %.1fus max %.1fus (n=%llu)",
+                      histogram.percentileNs(0.50) / 1000.0,
+                      histogram.percentileNs(0.99) / 1000.0,
+                      histogram.maxNs() / 1000.0,
+                      static_cast<unsigned long long>(histogram.count()));
+        return buffer;
+    }
+
+    static constexpr char kCheckpointMagic[8] = {'S', 'D', 'P', 'F', 'C', 'K', 'P', '1'};
+    static constexpr size_t kDefaultWorkerBatchSize = 32;
+    static constexpr size_t kChunksPerRefill = 4;
+    static constexpr size_t kDefaultReorderWindow = 4096;
+    static constexpr int kDefaultScaleIntervalMs = 100;
+    static constexpr double kScaleUpUtilization = 0.85;
+    static constexpr double kScaleDownUtilization = 0.30;
+    static constexpr int kScaleDownTicks = 5;
+
+    size_t numWorkers_;
+    size_t workerBatchSize_;
+    size_t queueSize_;
+    SchedulingMode schedulingMode_;
+    DistributionPolicy distributionPolicy_;
+    BackpressurePolicy backpressure_;
+    PlacementPolicy placement_;
+    CpuTopology topology_;
+    std::vector<int> workerCpus_;                 // By worker id; empty when unpinned
+    std::vector<std::vector<size_t>> nodeShards_; // Shard ids by topology node
+    std::vector<std::vector<size_t>> stealOrder_; // Peer shard ids, nearest first
+    QueueT<WorkItem> inputQueue_;
+    std::vector<LaneConfig> inputLanes_;          // As set; applied at start()
+    bool lanesActive_ = false;
+    // Loaded by restoreCheckpoint(), handed on by start()
+    std::vector<std::pair<uint64_t, std::vector<uint8_t>>> restoredPartitions_;
+    std::vector<WorkItem> restoredInput_;
+    QueueT<T> outputQueue_;
+    std::vector<std::unique_ptr<WorkerShard>> shards_;
+    
+    std::vector<std::thread> workers_;
+    std::atomic<bool> isRunning_;
+
+    // Elastic pool: workers with an id at or above activeWorkers_ park
+    bool elastic_;
+    size_t minWorkers_;
+    size_t maxWorkers_;
+    int scaleIntervalMs_;
+    std::atomic<size_t> activeWorkers_;
+    std::mutex parkMutex_;
+    std::condition_variable parked_;
+    std::thread scaler_;
+    std::mutex scalerMutex_;
+    std::condition_variable scalerWake_;
+
+    // Idle stealing workers sleep until work becomes visible
+    std::mutex idleMutex_;
+    std::condition_variable workAvailable_;
+    std::atomic<size_t> idleWorkers_;
+
+    // Items accepted but not yet delivered, for drain()
+    std::atomic<size_t> inFlight_;
+    std::mutex drainMutex_;
+    std::condition_variable drained_;
+
+    std::atomic<bool> shardsClosed_;
+    std::atomic<size_t> nextShard_;
+    std::atomic<ProcessingSystem*> downstream_;
+    std::unique_ptr<QueueT<KeyedResult<T>>> keyedOutputQueue_; // Partitioned mode only
+
+    // Ordered output
+    bool orderedOutput_;
+    size_t reorderWindow_;
+    std::mutex sequenceMutex_;
+    uint64_t nextSequence_;
+    std::unique_ptr<ReorderBuffer<T>> reorder_;
+    
+    // Published with std::atomic_store, read as snapshots with std::atomic_load
+    std::shared_ptr<Processor<T>> processor_;
+    std::atomic<uint64_t> processorVersion_;
+    std::shared_ptr<ResultSink<T>> sink_; // Same publication scheme as processor_
+    std::atomic<uint64_t> sinkVersion_;
+    std::mutex serialMutex_;
+    
+    // Hot-path counters: one cache line per worker, summed on read
+    ShardedCounter totalProcessed_;
+    ShardedCounter totalErrors_;
+    ShardedCounter totalFiltered_;
+
+    // Per-worker, cache-line padded; each is written only by its worker
+    std::vector<std::unique_ptr<WorkerMetrics>> workerMetrics_;
+    ShardedCounter inputTimeouts_; // Written by producer threads
+    ShardedCounter inputShed_;
+    ShardedCounter callerRuns_;
+
+    // CALLER_RUNS: producers borrow this context in turn
+    std::mutex callerMutex_;
+    WorkerContext callerContext_;
+    WorkerMetrics callerMetrics_;
+    std::vector<WorkItem> callerBatch_;
 };
@@ -2,8 +2,18 @@
 
 #include <string>
 #include <memory>
+#include <optional>
 #include <typeinfo>
+#include <cstdint>
 #include "Logger.h"
+#include "Checkpoint.h"
+#include "SimdKernels.h"
+
+// Hit/miss counts of processors that memoize results
+struct CacheCounters {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
 
 template<typename T>
 class Processor {
@@ -12,6 +22,52 @@ public:
 
     virtual T process(const T& input) = 0;
 
+    // Process n items from in into out. The default calls process() per
+    // item; processors with a vectorized kernel override it.
+    virtual void processBatch(const T* in, T* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = process(in[i]);
+        }
+    }
+
+    // Transform value without producing a copy. Processors that can do
+    // this cheaper than process() override it and return true from
+    // processesInPlace(), so workers hand them their buffered items.
+    virtual void processInPlace(T& value) {
+        value = process(value);
+    }
+
+    virtual bool processesInPlace() const {
+        return false;
+    }
+
+    // Processors that can discard items return true from dropsItems();
+    // workers then use the filtering calls below and forward only what is
+    // kept, so a rejected item costs neither a result nor a delivery.
+    virtual bool dropsItems() const {
+        return false;
+    }
+
+    // Process one item, or return nullopt to drop it. The default never drops.
+    virtual std::optional<T> tryProcess(const T& input) {
+        return process(input);
+    }
+
+    // Batch form of tryProcess(): the kept results go to the front of out
+    // in input order and keep[i] records whether in[i] was kept. Returns
+    // the number kept. As with processBatch(), out may alias in.
+    virtual size_t processBatchFiltered(const T* in, T* out, uint8_t* keep, size_t n) {
+        size_t kept = 0;
+        for (size_t i = 0; i < n; ++i) {
+            std::optional<T> result = tryProcess(in[i]);
+            keep[i] = result ? 1 : 0;
+            if (result) {
+                out[kept++] = std::move(*result);
+            }
+        }
+        return kept;
+    }
+
     virtual std::string getName() const = 0;
 
     std::string getDataType() const {
@@ -21,6 +77,60 @@ public:
     virtual void reset() {
         LOG_INFO("Processor reset: " + getName());
     }
+
+    // Stateless processors may run concurrently on every worker.
+    // Stateful ones are serialized by the ProcessingSystem.
+    virtual bool isStateless() const {
+        return false;
+    }
+
+    // Whether a worker may run a batch through the batch kernel and, if
+    // it throws, again item by item. Only safe when applying an item twice
+    // is harmless, so stateful processors are run item by item instead.
+    virtual bool canRetryBatch() const {
+        return isStateless();
+    }
+
+    // Whether results depend on the order items arrive in. In ordered
+    // mode such processors only run once the reorder buffer has put
+    // their input back in order.
+    virtual bool needsInputOrder() const {
+        return !isStateless();
+    }
+
+    // Pure processors always map the same input to the same result (or
+    // drop it every time) and have no side effects, so their results can
+    // be memoized (see CachingProcessor).
+    virtual bool isPure() const {
+        return false;
+    }
+
+    // Hits and misses of any result cache in this processor
+    virtual CacheCounters cacheCounters() const {
+        return {};
+    }
+
+    // Save whatever state process() has built up, for a checkpoint. A
+    // stateless processor has none and succeeds without writing; a
+    // stateful one that does not override this cannot be checkpointed.
+    virtual bool snapshot(ByteWriter& out) const {
+        (void)out;
+        return isStateless();
+    }
+
+    // Load state written by snapshot() of a processor of the same kind
+    // and configuration
+    virtual bool restore(ByteReader& in) {
+        (void)in;
+        return isStateless();
+    }
+
+    // Independent copy of this processor, including its current state.
+    // Used to give each partition a private instance; processors that
+    // cannot be copied return nullptr.
+    virtual std::shared_ptr<Processor<T>> clone() const {
+        return nullptr;
+    }
 };
 
 // ============ CONCRETE IMPLEMENTATIONS ============
@@ -37,10 +147,30 @@ public:
         return result;
     }
 
+    void processBatch(const T* in, T* out, size_t n) override {
+        if constexpr (simd::IsVectorizable<T>::value) {
+            simd::multiply(in, out, n, multiplier_);
+        } else {
+            Processor<T>::processBatch(in, out, n);
+        }
+    }
+
     std::string getName() const override {
         return "NumericProcessor";
     }
 
+    std::shared_ptr<Processor<T>> clone() const override {
+        return std::make_shared<NumericProcessor>(*this);
+    }
+
+    bool isStateless() const override {
+        return true;
+    }
+
+    bool isPure() const override {
+        return true;
+    }
+
 private:
     T multiplier_;
 };
@@ -53,6 +183,9 @@ public:
 
     std::string process(const std::string& input) override {
         std::string result;
+        if (repetitions_ > 0) {
+            result.reserve(input.size() * static_cast<size_t>(repetitions_));
+        }
         for (int i = 0; i < repetitions_; ++i) {
             result += input;
         }
@@ -60,10 +193,40 @@ public:
         return result;
     }
 
+    void processInPlace(std::string& value) override {
+        if (repetitions_ <= 0) {
+            value.clear();
+            return;
+        }
+        size_t length = value.size();
+        // Reserve first so appending from our own buffer never reallocates
+        value.reserve(length * static_cast<size_t>(repetitions_));
+        for (int i = 1; i < repetitions_; ++i) {
+            value.append(value.data(), length);
+        }
+        LOG_DEBUG("StringProcessor: in-place repeat " + std::to_string(repetitions_) + " times");
+    }
+
+    bool processesInPlace() const override {
+        return true;
+    }
+
     std::string getName() const override {
         return "StringProcessor";
     }
 
+    std::shared_ptr<Processor<std::string>> clone() const override {
+        return std::make_shared<NumericProcessor>(*this);
+    }
+
+    bool isStateless() const override {
+        return true;
+    }
+
+    bool isPure() const override {
+        return true;
+    }
+
 private:
     int repetitions_;
 };
@@ -74,9 +237,9 @@ class StatisticalProcessor : public Processor<T> {
 public:
     T process(const T& input) override {
         // For numeric types: apply smoothing/averaging
-        total_ += input;
+        total_ += static_cast<double>(input);
         count_++;
-        T average = total_ / count_;
+        T average = static_cast<T>(total_ / static_cast<double>(count_));
         LOG_DEBUG("StatisticalProcessor: average = " + std::to_string(average));
         return average;
     }
@@ -85,6 +248,25 @@ public:
         return "StatisticalProcessor";
     }
 
+    std::shared_ptr<Processor<T>> clone() const override {
+        return std::make_shared<StatisticalProcessor>(*this);
+    }
+
+    bool snapshot(ByteWriter& out) const override {
+        out.write(total_);
+        out.writeVarint(count_);
+        return true;
+    }
+
+    bool restore(ByteReader& in) override {
+        double total;
+        uint64_t count;
+        if (!in.read(total) || !in.readVarint(count)) return false;
+        total_ = total;
+        count_ = count;
+        return true;
+    }
+
     void reset() override {
         total_ = 0;
         count_ = 0;
@@ -92,8 +274,9 @@ public:
     }
 
 private:
-    T total_ = 0;
-    int count_ = 0;
+    // Accumulated in double so integer input cannot overflow
+    double total_ = 0;
+    uint64_t count_ = 0;
 };
 
 // Filtering Processor - filters data based on threshold
@@ -111,10 +294,51 @@ public:
         return T();
     }
 
+    void processBatch(const T* in, T* out, size_t n) override {
+        if constexpr (simd::IsVectorizable<T>::value) {
+            simd::threshold(in, out, n, threshold_);
+        } else {
+            Processor<T>::processBatch(in, out, n);
+        }
+    }
+
+    // Inside a ProcessingSystem rejected items are dropped rather than
+    // replaced by T(); process() keeps the old behaviour for direct callers
+    bool dropsItems() const override {
+        return true;
+    }
+
+    std::optional<T> tryProcess(const T& input) override {
+        if (input >= threshold_) {
+            return input;
+        }
+        return std::nullopt;
+    }
+
+    size_t processBatchFiltered(const T* in, T* out, uint8_t* keep, size_t n) override {
+        if constexpr (simd::IsVectorizable<T>::value) {
+            return simd::compactThreshold(in, out, keep, n, threshold_);
+        } else {
+            return simd::compactThresholdScalar(in, out, keep, n, threshold_);
+        }
+    }
+
     std::string getName() const override {
         return "FilteringProcessor";
     }
 
+    std::shared_ptr<Processor<T>> clone() const override {
+        return std::make_shared<FilteringProcessor>(*this);
+    }
+
+    bool isStateless() const override {
+        return true;
+    }
+
+    bool isPure() const override {
+        return true;
+    }
+
 private:
     T threshold_;
 };
@@ -131,10 +355,30 @@ public:
         return result;
     }
 
+    void processBatch(const T* in, T* out, size_t n) override {
+        if constexpr (simd::IsVectorizable<T>::value) {
+            simd::amplify(in, out, n, gain_);
+        } else {
+            Processor<T>::processBatch(in, out, n);
+        }
+    }
+
     std::string getName() const override {
         return "AmplificationProcessor";
     }
 
+    std::shared_ptr<Processor<T>> clone() const override {
+        return std::make_shared<AmplificationProcessor>(*this);
+    }
+
+    bool isStateless() const override {
+        return true;
+    }
+
+    bool isPure() const override {
+        return true;
+    }
+
 private:
     double gain_;
 };
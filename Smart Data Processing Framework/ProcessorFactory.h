@@ -2,6 +2,10 @@
 
 #include <memory>
 #include <map>
+#include <unordered_map>
+#include <string>
+#include <variant>
+#include <mutex>
 #include <functional>
 #include <stdexcept>
 #include "Processor.h"
@@ -13,42 +17,170 @@ enum class ProcessorType {
     AMPLIFICATION
 };
 
+// Typed parameters of each ProcessorType. Creating a processor from one
+// of these skips the string lookups of the parameter map.
+struct NumericConfig {
+    double multiplier = 2.0;    // numbers are multiplied by this
+    int repetitions = 2;        // strings are repeated this many times
+};
+
+struct StatisticalConfig {};
+
+struct FilteringConfig {
+    double threshold = 0.0;
+};
+
+struct AmplificationConfig {
+    double gain = 1.5;
+};
+
+// Alternatives are in ProcessorType order
+using ProcessorConfig = std::variant<NumericConfig, StatisticalConfig, FilteringConfig, AmplificationConfig>;
+
+static_assert(std::variant_size<ProcessorConfig>::value == static_cast<size_t>(ProcessorType::AMPLIFICATION) + 1,
+              "ProcessorConfig needs one alternative per ProcessorType");
+
+inline ProcessorType typeOf(const ProcessorConfig& config) {
+    return static_cast<ProcessorType>(config.index());
+}
+
+// Read a parameter map into the typed config of type, once. Missing
+// parameters keep their defaults and unknown ones are ignored.
+inline ProcessorConfig parseProcessorConfig(ProcessorType type,
+                                            const std::map<std::string, double>& params = {}) {
+    auto lookup = [&params](const char* name, double fallback) {
+        auto it = params.find(name);
+        return it != params.end() ? it->second : fallback;
+    };
+    switch (type) {
+        case ProcessorType::NUMERIC: {
+            NumericConfig config;
+            config.multiplier = lookup("multiplier", config.multiplier);
+            config.repetitions = static_cast<int>(lookup("repetitions", config.repetitions));
+            return config;
+        }
+        case ProcessorType::STATISTICAL:
+            return StatisticalConfig{};
+        case ProcessorType::FILTERING:
+            return FilteringConfig{lookup("threshold", 0.0)};
+        case ProcessorType::AMPLIFICATION:
+            return AmplificationConfig{lookup("gain", 1.5)};
+        default:
+            throw std::invalid_argument("Unknown processor type");
+    }
+}
+
+// A configured processor built once and handed out for every job that
+// needs it. A stateless prototype is shared as it is, which costs a
+// reference count; a stateful one is cloned, so every instance starts
+// from the prototype's fresh state.
 template<typename T>
-class ProcessorFactory {
+class ProcessorPrototype {
+public:
+    ProcessorPrototype() = default;
+
+    explicit ProcessorPrototype(std::shared_ptr<Processor<T>> processor)
+        : processor_(std::move(processor)), shared_(processor_ && processor_->isStateless()) {}
+
+    // Null when the prototype is stateful and cannot be cloned
+    std::shared_ptr<Processor<T>> instance() const {
+        if (!processor_ || shared_) return processor_;
+        return processor_->clone();
+    }
+
+    bool sharesInstance() const {
+        return shared_;
+    }
+
+    explicit operator bool() const {
+        return processor_ != nullptr;
+    }
+
+private:
+    std::shared_ptr<Processor<T>> processor_;
+    bool shared_ = false;
+};
+
+// Processor types added at run time, created by name, for processors the
+// built-in ProcessorType switch does not know about
+template<typename T>
+class ProcessorRegistry {
+public:
+    using Creator = std::function<std::shared_ptr<Processor<T>>(const std::map<std::string, double>&)>;
+
+    // Replaces an earlier registration of the same name
+    void registerProcessor(const std::string& name, Creator creator) {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        creators_[name] = std::move(creator);
+    }
+
+    bool isRegistered(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(registryMutex_);
+        return creators_.count(name) != 0;
+    }
+
+    std::shared_ptr<Processor<T>> createProcessor(const std::string& name,
+                                                  const std::map<std::string, double>& params = {}) const {
+        Creator creator;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex_);
+            auto it = creators_.find(name);
+            if (it == creators_.end()) {
+                throw std::invalid_argument("Unknown processor type: " + name);
+            }
+            creator = it->second;
+        }
+        return creator(params);
+    }
+
+protected:
+    ProcessorRegistry() = default;
+
+private:
+    mutable std::mutex registryMutex_;
+    std::unordered_map<std::string, Creator> creators_;
+};
+
+template<typename T>
+class ProcessorFactory : public ProcessorRegistry<T> {
 public:
     static ProcessorFactory& getInstance() {
         static ProcessorFactory instance;
         return instance;
     }
 
+    using ProcessorRegistry<T>::createProcessor;
+
     std::shared_ptr<Processor<T>> createProcessor(
         ProcessorType type,
         const std::map<std::string, double>& params = {}) {
-        
-        switch (type) {
-            case ProcessorType::NUMERIC: {
-                double multiplier = params.count("multiplier") ? 
-                    params.at("multiplier") : 2.0;
-                return std::make_shared<NumericProcessor<T>>(
-                    static_cast<T>(multiplier));
-            }
-            case ProcessorType::STATISTICAL: {
-                return std::make_shared<StatisticalProcessor<T>>();
-            }
-            case ProcessorType::FILTERING: {
-                double threshold = params.count("threshold") ? 
-                    params.at("threshold") : 0.0;
-                return std::make_shared<FilteringProcessor<T>>(
-                    static_cast<T>(threshold));
-            }
-            case ProcessorType::AMPLIFICATION: {
-                double gain = params.count("gain") ? 
-                    params.at("gain") : 1.5;
-                return std::make_shared<AmplificationProcessor<T>>(gain);
-            }
-            default:
-                throw std::invalid_argument("Unknown processor type");
-        }
+        return createProcessor(parseProcessorConfig(type, params));
+    }
+
+    std::shared_ptr<Processor<T>> createProcessor(const ProcessorConfig& config) {
+        return std::visit([this](const auto& typed) { return createProcessor(typed); }, config);
+    }
+
+    std::shared_ptr<Processor<T>> createProcessor(const NumericConfig& config) {
+        return std::make_shared<NumericProcessor<T>>(static_cast<T>(config.multiplier));
+    }
+
+    std::shared_ptr<Processor<T>> createProcessor(const StatisticalConfig&) {
+        return std::make_shared<StatisticalProcessor<T>>();
+    }
+
+    std::shared_ptr<Processor<T>> createProcessor(const FilteringConfig& config) {
+        return std::make_shared<FilteringProcessor<T>>(static_cast<T>(config.threshold));
+    }
+
+    std::shared_ptr<Processor<T>> createProcessor(const AmplificationConfig& config) {
+        return std::make_shared<AmplificationProcessor<T>>(config.gain);
+    }
+
+    // Build once, hand out with instance(): anything createProcessor takes
+    template<typename... Args>
+    ProcessorPrototype<T> prototype(const Args&... args) {
+        return ProcessorPrototype<T>(createProcessor(args...));
     }
 
 private:
@@ -59,30 +191,31 @@ private:
 
 // Specialization for string type
 template<>
-class ProcessorFactory<std::string> {
+class ProcessorFactory<std::string> : public ProcessorRegistry<std::string> {
 public:
     static ProcessorFactory& getInstance() {
         static ProcessorFactory instance;
         return instance;
     }
 
+    using ProcessorRegistry<std::string>::createProcessor;
+
     std::shared_ptr<Processor<std::string>> createProcessor(
         ProcessorType type,
         const std::map<std::string, double>& params = {}) {
-        
-        switch (type) {
-            case ProcessorType::NUMERIC: {
-                int repetitions = params.count("repetitions") ? 
-                    static_cast<int>(params.at("repetitions")) : 2;
-                return std::make_shared<NumericProcessor<std::string>>(repetitions);
-            }
-            case ProcessorType::STATISTICAL:
-            case ProcessorType::FILTERING:
-            case ProcessorType::AMPLIFICATION:
-                throw std::invalid_argument("This processor type is not supported for strings");
-            default:
-                throw std::invalid_argument("Unknown processor type");
+        return createProcessor(parseProcessorConfig(type, params));
+    }
+
+    std::shared_ptr<Processor<std::string>> createProcessor(const ProcessorConfig& config) {
+        if (auto numeric = std::get_if<NumericConfig>(&config)) {
+            return std::make_shared<NumericProcessor<std::string>>(numeric->repetitions);
         }
+        throw std::invalid_argument("This processor type is not supported for strings");
+    }
+
+    template<typename... Args>
+    ProcessorPrototype<std::string> prototype(const Args&... args) {
+        return ProcessorPrototype<std::string>(createProcessor(args...));
     }
 
 private:
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <optional>
+#include <vector>
+#include <cstdint>
+
+// Bounded window that turns results finished out of order back into
+// sequence order. Sequence numbers must be dense: every number has to be
+// inserted once, either with a value or as dropped. A caller whose next
+// sequence number lies beyond the window waits until the window has moved
+// on, which is the backpressure that keeps memory bounded.
+//
+// Whoever fills the slot at the release point becomes the releaser and
+// hands contiguous runs to its deliver callback outside the lock; only
+// one releaser runs at a time, so runs are delivered in order.
+template<typename T>
+class ReorderBuffer {
+public:
+    explicit ReorderBuffer(size_t window, uint64_t firstSequence = 0)
+        : capacity_(roundUpToPowerOfTwo(window)),
+          mask_(capacity_ - 1),
+          slots_(new Slot[capacity_]),
+          nextRelease_(firstSequence),
+          releasing_(false) {}
+
+    ReorderBuffer(const ReorderBuffer&) = delete;
+    ReorderBuffer& operator=(const ReorderBuffer&) = delete;
+
+    // Insert one batch. sequences holds one number per input item in
+    // ascending order; dropped lists (ascending) the indices into sequences
+    // that produced no result; values holds the other items' results in
+    // order and is moved from. Items inserted as deferred reach the
+    // callback with deferred == true so it can finish them in order.
+    //
+    // deliver(std::vector<T>& run, bool deferred) may move from run.
+    template<typename Deliver>
+    void insert(const std::vector<uint64_t>& sequences, const std::vector<size_t>& dropped,
+                std::vector<T>& values, bool deferred, Deliver&& deliver) {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        size_t nextDropped = 0;
+        size_t nextValue = 0;
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            uint64_t sequence = sequences[i];
+            waitForRoom(lock, sequence, deliver);
+
+            Slot& slot = slots_[sequence & mask_];
+            if (nextDropped < dropped.size() && dropped[nextDropped] == i) {
+                ++nextDropped;
+            } else if (nextValue < values.size()) {
+                slot.value.emplace(std::move(values[nextValue++]));
+            }
+            slot.deferred = deferred;
+            slot.ready = true;
+        }
+
+        releaseReady(lock, deliver);
+    }
+
+    // Sequence numbers released so far
+    uint64_t released() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nextRelease_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+private:
+    struct Slot {
+        std::optional<T> value;
+        bool ready = false;
+        bool deferred = false;
+    };
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t capacity = 1;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    template<typename Deliver>
+    void waitForRoom(std::unique_lock<std::mutex>& lock, uint64_t sequence, Deliver& deliver) {
+        while (sequence >= nextRelease_ + capacity_) {
+            // Release what we can first: the slot we are waiting on may
+            // already be filled by an earlier item of our own batch
+            if (!releasing_) {
+                releaseReady(lock, deliver);
+                if (sequence < nextRelease_ + capacity_) break;
+            }
+            roomAvailable_.wait(lock);
+        }
+    }
+
+    template<typename Deliver>
+    void releaseReady(std::unique_lock<std::mutex>& lock, Deliver& deliver) {
+        if (releasing_) return;
+        releasing_ = true;
+
+        while (slots_[nextRelease_ & mask_].ready) {
+            bool deferred = slots_[nextRelease_ & mask_].deferred;
+            run_.clear();
+            for (;;) {
+                Slot& slot = slots_[nextRelease_ & mask_];
+                if (!slot.ready || slot.deferred != deferred) break;
+                if (slot.value) {
+                    run_.push_back(std::move(*slot.value));
+                    slot.value.reset();
+                }
+                slot.ready = false;
+                ++nextRelease_;
+            }
+            roomAvailable_.notify_all();
+
+            lock.unlock();
+            if (!run_.empty()) {
+                deliver(run_, deferred);
+            }
+            lock.lock();
+        }
+
+        releasing_ = false;
+    }
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable roomAvailable_;
+    uint64_t nextRelease_;
+    bool releasing_;
+    std::vector<T> run_; // Owned by the current releaser
+};
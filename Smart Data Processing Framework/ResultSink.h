@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <exception>
+#include <string>
+
+#include "PartitionKey.h"
+#include "Logger.h"
+
+// Receives results straight from the worker threads instead of having
+// them parked in the system's output queue. Workers call it concurrently,
+// once per processed batch, so implementations must be thread-safe.
+template<typename T>
+class ResultSink {
+public:
+    virtual ~ResultSink() = default;
+
+    // Take the results (they may be moved from). Returns how many were
+    // accepted; the rest are counted as delivery errors.
+    virtual size_t deliver(std::vector<T>& results) = 0;
+
+    // Results of keyed items in SchedulingMode::PARTITIONED. The default
+    // drops the key.
+    virtual size_t deliverKeyed(PartitionKey key, std::vector<T>& results) {
+        (void)key;
+        return deliver(results);
+    }
+};
+
+// Calls back once per result
+template<typename T>
+class CallbackSink : public ResultSink<T> {
+public:
+    using Callback = std::function<void(T&&)>;
+    using KeyedCallback = std::function<void(PartitionKey, T&&)>;
+
+    explicit CallbackSink(Callback callback, KeyedCallback keyedCallback = nullptr)
+        : callback_(std::move(callback)), keyedCallback_(std::move(keyedCallback)) {}
+
+    size_t deliver(std::vector<T>& results) override {
+        size_t accepted = 0;
+        for (auto& result : results) {
+            try {
+                callback_(std::move(result));
+                ++accepted;
+            } catch (const std::exception& e) {
+                LOG_ERROR("Result callback exception: " + std::string(e.what()));
+            }
+        }
+        return accepted;
+    }
+
+    size_t deliverKeyed(PartitionKey key, std::vector<T>& results) override {
+        if (!keyedCallback_) {
+            return deliver(results);
+        }
+        size_t accepted = 0;
+        for (auto& result : results) {
+            try {
+                keyedCallback_(key, std::move(result));
+                ++accepted;
+            } catch (const std::exception& e) {
+                LOG_ERROR("Result callback exception: " + std::string(e.what()));
+            }
+        }
+        return accepted;
+    }
+
+private:
+    Callback callback_;
+    KeyedCallback keyedCallback_;
+};
+
+// Calls back once per worker batch with the whole batch
+template<typename T>
+class BatchCallbackSink : public ResultSink<T> {
+public:
+    using Callback = std::function<void(std::vector<T>&)>;
+
+    explicit BatchCallbackSink(Callback callback) : callback_(std::move(callback)) {}
+
+    // The callback may take the batch, so count it first
+    size_t deliver(std::vector<T>& results) override {
+        size_t count = results.size();
+        try {
+            callback_(results);
+            return count;
+        } catch (const std::exception& e) {
+            LOG_ERROR("Batch result callback exception: " + std::string(e.what()));
+            return 0;
+        }
+    }
+
+private:
+    Callback callback_;
+};
+
+// Moves results into a queue the user owns, e.g. a consumer's own
+// DataQueue or RingBufferQueue, with one bulk enqueue per batch
+template<typename T, template<typename> class QueueT>
+class QueueSink : public ResultSink<T> {
+public:
+    explicit QueueSink(std::shared_ptr<QueueT<T>> queue, int timeoutMs = 500)
+        : queue_(std::move(queue)), timeoutMs_(timeoutMs) {}
+
+    size_t deliver(std::vector<T>& results) override {
+        return queue_->enqueueBulk(std::move(results), timeoutMs_);
+    }
+
+private:
+    std::shared_ptr<QueueT<T>> queue_;
+    int timeoutMs_;
+};
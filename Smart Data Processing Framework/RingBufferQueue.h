@@ -0,0 +1,418 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <optional>
+#include <chrono>
+#include <thread>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CacheLine.h"
+
+// Bounded lock-free MPMC queue (Vyukov sequence-numbered ring).
+// Drop-in alternative to DataQueue: same enqueue/dequeue/timeout/shutdown
+// semantics, but the fast path is a single CAS. Blocked callers spin, then
+// yield, then park on a condition variable that is only touched when
+// somebody is actually asleep. The ring is rounded up to a power of two;
+// a maxSize that is not one costs an extra load of the head per enqueue.
+template<typename T>
+class RingBufferQueue {
+public:
+    explicit RingBufferQueue(size_t maxSize = 10000)
+        : maxSize_(maxSize),
+          capacity_(roundUpToPowerOfTwo(maxSize)),
+          mask_(capacity_ - 1),
+          cells_(new Cell[capacity_]),
+          shutdown_(false) {
+        for (size_t i = 0; i < capacity_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        head_.value.store(0, std::memory_order_relaxed);
+        tail_.value.store(0, std::memory_order_relaxed);
+    }
+
+    ~RingBufferQueue() {
+        shutdown();
+        while (tryDequeue()) {
+        }
+    }
+
+    RingBufferQueue(const RingBufferQueue&) = delete;
+    RingBufferQueue& operator=(const RingBufferQueue&) = delete;
+
+    // Add item to queue
+    bool enqueue(const T& item, int timeoutMs = -1) {
+        return emplaceFor(timeoutMs, item);
+    }
+
+    bool enqueue(T&& item, int timeoutMs = -1) {
+        return emplaceFor(timeoutMs, std::move(item));
+    }
+
+    // Construct an item in place, waiting as long as needed for room
+    template<typename... Args>
+    bool emplace(Args&&... args) {
+        return emplaceFor(-1, std::forward<Args>(args)...);
+    }
+
+    // Construct an item in place, waiting at most timeoutMs for room.
+    // The arguments are only consumed once a slot has been claimed.
+    template<typename... Args>
+    bool emplaceFor(int timeoutMs, Args&&... args) {
+        bool added = waitUntil(notFull_, timeoutMs, true, [&] {
+            return tryEmplace(std::forward<Args>(args)...);
+        });
+        if (added) {
+            wakeOne(notEmpty_);
+        }
+        return added;
+    }
+
+    // Retrieve and remove item from queue
+    std::optional<T> dequeue(int timeoutMs = -1) {
+        std::optional<T> item;
+        waitUntil(notEmpty_, timeoutMs, false, [&] {
+            item = tryDequeue();
+            return item.has_value();
+        });
+        if (item) {
+            wakeOne(notFull_);
+        }
+        return item;
+    }
+
+    // Add a range of items, waking consumers once per batch.
+    // Returns the number of items added before a timeout or shutdown.
+    template<typename InputIt>
+    size_t enqueueBulk(InputIt first, InputIt last, int timeoutMs = -1) {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 0);
+
+        size_t added = 0;
+        size_t unsignalled = 0;
+        while (first != last && !isShutdown()) {
+            if (tryEnqueue(*first)) {
+                ++first;
+                ++added;
+                ++unsignalled;
+                continue;
+            }
+
+            // Full: let consumers in on what we have so far, then wait
+            wakeBatch(notEmpty_, unsignalled);
+            unsignalled = 0;
+            int remainingMs = -1;
+            if (timeoutMs > 0) {
+                remainingMs = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - std::chrono::steady_clock::now()).count());
+                if (remainingMs <= 0) break;
+            }
+            if (!waitUntil(notFull_, remainingMs, true, [&] { return tryEnqueue(*first); })) {
+                break;
+            }
+            ++first;
+            ++added;
+            ++unsignalled;
+        }
+        wakeBatch(notEmpty_, unsignalled);
+        return added;
+    }
+
+    size_t enqueueBulk(const std::vector<T>& items, int timeoutMs = -1) {
+        return enqueueBulk(items.begin(), items.end(), timeoutMs);
+    }
+
+    // Moves the items in; the ones not accepted are left moved-from
+    size_t enqueueBulk(std::vector<T>&& items, int timeoutMs = -1) {
+        return enqueueBulk(std::make_move_iterator(items.begin()),
+                           std::make_move_iterator(items.end()), timeoutMs);
+    }
+
+    // Move up to maxItems into out. Waits (up to timeoutMs) only until at
+    // least one item is available. Returns the number of items appended.
+    size_t dequeueBulk(std::vector<T>& out, size_t maxItems, int timeoutMs = -1) {
+        if (maxItems == 0) return 0;
+
+        std::optional<T> first;
+        waitUntil(notEmpty_, timeoutMs, false, [&] {
+            first = tryDequeue();
+            return first.has_value();
+        });
+        if (!first) return 0;
+
+        out.push_back(std::move(*first));
+        size_t taken = 1;
+        while (taken < maxItems) {
+            auto item = tryDequeue();
+            if (!item) break;
+            out.push_back(std::move(*item));
+            ++taken;
+        }
+
+        wakeBatch(notFull_, taken);
+        return taken;
+    }
+
+    // Non-blocking variants
+    bool tryEnqueue(const T& item) {
+        return tryEmplace(item);
+    }
+
+    bool tryEnqueue(T&& item) {
+        return tryEmplace(std::move(item));
+    }
+
+    template<typename... Args>
+    bool tryEmplace(Args&&... args) {
+        size_t pos = tail_.value.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (maxSize_ != capacity_ && isAtLimit(pos)) {
+                    return false; // Full at maxSize, with ring slots to spare
+                }
+                if (tail_.value.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = tail_.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        new (cell->storage) T(std::forward<Args>(args)...);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Add as many items as fit right now; the rest are left untouched
+    template<typename InputIt>
+    size_t tryEnqueueBulk(InputIt first, InputIt last) {
+        size_t added = 0;
+        while (first != last && !isShutdown() && tryEnqueue(*first)) {
+            ++first;
+            ++added;
+        }
+        wakeBatch(notEmpty_, added);
+        return added;
+    }
+
+    std::optional<T> tryDequeue() {
+        size_t pos = head_.value.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (head_.value.compare_exchange_weak(pos, pos + 1,
+                                                      std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return std::nullopt; // Empty
+            } else {
+                pos = head_.value.load(std::memory_order_relaxed);
+            }
+        }
+
+        T* slot = cell->item();
+        std::optional<T> item(std::move(*slot));
+        slot->~T();
+        cell->sequence.store(pos + capacity_, std::memory_order_release);
+        return item;
+    }
+
+    // Get queue size (approximate while producers/consumers are active)
+    size_t size() const {
+        size_t head = head_.value.load(std::memory_order_acquire);
+        size_t tail = tail_.value.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    bool full() const {
+        return size() >= maxSize_;
+    }
+
+    // Clear all items
+    void clear() {
+        while (tryDequeue()) {
+        }
+        wakeAll(notFull_);
+    }
+
+    // Gracefully shutdown queue
+    void shutdown() {
+        shutdown_.store(true, std::memory_order_seq_cst);
+        wakeAll(notEmpty_);
+        wakeAll(notFull_);
+    }
+
+    // Accept items again after shutdown(). Items still queued are kept.
+    void reopen() {
+        shutdown_.store(false, std::memory_order_seq_cst);
+    }
+
+    bool isShutdown() const {
+        return shutdown_.load(std::memory_order_acquire);
+    }
+
+    // Get statistics
+    struct Stats {
+        size_t currentSize;
+        size_t maxSize;
+        bool isFull;
+        bool isEmpty;
+        uint64_t totalEnqueued;
+        uint64_t totalDequeued;
+    };
+
+    // The ring indices only ever grow, so they double as throughput
+    // counters at no cost to the fast path
+    Stats getStats() const {
+        size_t head = head_.value.load(std::memory_order_acquire);
+        size_t tail = tail_.value.load(std::memory_order_acquire);
+        size_t current = tail > head ? tail - head : 0;
+        return {current, maxSize_, current >= maxSize_, current == 0, tail, head};
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* item() {
+            return std::launder(reinterpret_cast<T*>(storage));
+        }
+    };
+
+    struct alignas(kCacheLineSize) PaddedIndex {
+        std::atomic<size_t> value;
+    };
+
+    // Parking spot for blocked callers, touched only when sleepers > 0
+    struct alignas(kCacheLineSize) WaitGroup {
+        std::atomic<int> sleepers{0};
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    static constexpr int kSpinIterations = 64;
+    static constexpr int kYieldIterations = 8;
+
+    // A stale head only ever overstates the size, so the limit is never
+    // exceeded; a stale pos is caught by the CAS that follows
+    bool isAtLimit(size_t pos) const {
+        size_t head = head_.value.load(std::memory_order_acquire);
+        return static_cast<std::intptr_t>(pos - head) >= static_cast<std::intptr_t>(maxSize_);
+    }
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t capacity = 2;
+        while (capacity < n) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    // Adaptive wait: spin, yield, then park until op() succeeds, the
+    // timeout expires or the queue shuts down. Producers give up as soon as
+    // the queue is shut down; consumers keep draining remaining items.
+    template<typename Op>
+    bool waitUntil(WaitGroup& group, int timeoutMs, bool isProducer, Op&& op) {
+        auto stopped = [&] { return isProducer && isShutdown(); };
+
+        if (stopped()) return false;
+        for (int i = 0; i < kSpinIterations; ++i) {
+            if (op()) return true;
+            if (isShutdown()) return !stopped() && op();
+            cpuRelax();
+        }
+        for (int i = 0; i < kYieldIterations; ++i) {
+            if (op()) return true;
+            if (isShutdown()) return !stopped() && op();
+            std::this_thread::yield();
+        }
+
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 0);
+
+        std::unique_lock<std::mutex> lock(group.mutex);
+        group.sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        bool success = false;
+        for (;;) {
+            if (stopped()) break;
+            if (op()) {
+                success = true;
+                break;
+            }
+            if (isShutdown()) break;
+
+            if (timeoutMs > 0) {
+                if (group.cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+                    success = !stopped() && op();
+                    break;
+                }
+            } else {
+                group.cv.wait(lock);
+            }
+        }
+
+        group.sleepers.fetch_sub(1, std::memory_order_relaxed);
+        return success;
+    }
+
+    void wakeOne(WaitGroup& group) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (group.sleepers.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(group.mutex);
+            group.cv.notify_one();
+        }
+    }
+
+    // One wakeup per batch: a single item needs one waiter, more may
+    // keep several busy
+    void wakeBatch(WaitGroup& group, size_t count) {
+        if (count == 1) {
+            wakeOne(group);
+        } else if (count > 1) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (group.sleepers.load(std::memory_order_relaxed) > 0) {
+                wakeAll(group);
+            }
+        }
+    }
+
+    void wakeAll(WaitGroup& group) {
+        std::lock_guard<std::mutex> lock(group.mutex);
+        group.cv.notify_all();
+    }
+
+    const size_t maxSize_;
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+
+    PaddedIndex head_;
+    PaddedIndex tail_;
+
+    WaitGroup notEmpty_;
+    WaitGroup notFull_;
+    std::atomic<bool> shutdown_;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <cstddef>
+#include <cstdint>
+
+#include "CacheLine.h"
+
+// Counter for hot paths written by many threads. Each slot sits on its
+// own cache line, so concurrent writers do not bounce a shared line;
+// load() sums the slots and is meant for the (rare) reader side.
+//
+// add() picks a slot from the calling thread, addAt() from a caller
+// supplied index such as a worker id.
+class ShardedCounter {
+public:
+    explicit ShardedCounter(size_t slots = defaultSlotCount())
+        : mask_(roundUpToPowerOfTwo(slots) - 1),
+          slots_(new Slot[mask_ + 1]) {}
+
+    ShardedCounter(const ShardedCounter&) = delete;
+    ShardedCounter& operator=(const ShardedCounter&) = delete;
+
+    void add(uint64_t n = 1) {
+        addAt(threadSlot(), n);
+    }
+
+    void addAt(size_t slot, uint64_t n = 1) {
+        slots_[slot & mask_].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    ShardedCounter& operator+=(uint64_t n) {
+        add(n);
+        return *this;
+    }
+
+    ShardedCounter& operator++() {
+        add(1);
+        return *this;
+    }
+
+    uint64_t load() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i <= mask_; ++i) {
+            total += slots_[i].value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void reset() {
+        for (size_t i = 0; i <= mask_; ++i) {
+            slots_[i].value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(kCacheLineSize) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+
+    static constexpr size_t kMaxSlots = 128;
+
+    static size_t defaultSlotCount() {
+        size_t threads = std::thread::hardware_concurrency();
+        return threads == 0 ? 8 : (threads < kMaxSlots ? threads : kMaxSlots);
+    }
+
+    static size_t roundUpToPowerOfTwo(size_t n) {
+        size_t capacity = 1;
+        while (capacity < n && capacity < kMaxSlots) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    // Threads are numbered in order of first use, so a small set of
+    // long-lived threads lands on distinct slots
+    static size_t threadSlot() {
+        static std::atomic<size_t> nextThread{0};
+        thread_local size_t slot = nextThread.fetch_add(1, std::memory_order_relaxed);
+        return slot;
+    }
+
+    size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+};
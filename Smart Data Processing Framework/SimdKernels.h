@@ -0,0 +1,689 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SDPF_SIMD_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SDPF_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang compile each kernel for its own instruction set so the rest of
+// the build keeps the baseline target; MSVC accepts intrinsics anywhere
+#if defined(__GNUC__) || defined(__clang__)
+#define SDPF_SIMD_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SDPF_SIMD_TARGET(isa)
+#endif
+
+// Vectorized batch kernels for the built-in numeric processors, selected
+// once at runtime from the CPU's capabilities. Every kernel produces the
+// same results as the scalar process() path it replaces.
+namespace simd {
+
+enum class Level { SCALAR, SSE, AVX2, NEON };
+
+inline Level detectLevel() {
+#if defined(SDPF_SIMD_X86)
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool sse41 = __builtin_cpu_supports("sse4.1");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    if (avx2) return Level::AVX2;
+    if (sse41) return Level::SSE;
+    return Level::SCALAR;
+#elif defined(SDPF_SIMD_NEON)
+    return Level::NEON;
+#else
+    return Level::SCALAR;
+#endif
+}
+
+inline Level activeLevel() {
+    static const Level level = detectLevel();
+    return level;
+}
+
+inline const char* levelName(Level level) {
+    switch (level) {
+    case Level::AVX2: return "AVX2";
+    case Level::SSE: return "SSE4.1";
+    case Level::NEON: return "NEON";
+    default: return "SCALAR";
+    }
+}
+
+// Element types that have vector kernels
+template<typename T>
+struct IsVectorizable : std::integral_constant<bool,
+    std::is_same<T, int32_t>::value ||
+    std::is_same<T, float>::value ||
+    std::is_same<T, double>::value> {};
+
+// ============ SCALAR REFERENCE KERNELS ============
+// Also used for the tail elements that do not fill a full vector
+
+template<typename T>
+void multiplyScalar(const T* in, T* out, size_t n, T factor) {
+    for (size_t i = 0; i < n; ++i) out[i] = in[i] * factor;
+}
+
+template<typename T>
+void amplifyScalar(const T* in, T* out, size_t n, double gain) {
+    for (size_t i = 0; i < n; ++i) out[i] = static_cast<T>(in[i] * gain);
+}
+
+template<typename T>
+void thresholdScalar(const T* in, T* out, size_t n, T threshold) {
+    for (size_t i = 0; i < n; ++i) out[i] = in[i] >= threshold ? in[i] : T();
+}
+
+// Branch-free: every item is written, but the cursor only advances past
+// the ones that pass. out may alias in.
+template<typename T>
+size_t compactThresholdScalar(const T* in, T* out, uint8_t* keep, size_t n, T threshold) {
+    size_t kept = 0;
+    for (size_t i = 0; i < n; ++i) {
+        T value = in[i];
+        uint8_t pass = value >= threshold ? 1 : 0;
+        out[kept] = value;
+        keep[i] = pass;
+        kept += pass;
+    }
+    return kept;
+}
+
+namespace detail {
+
+// Lookup tables for stream compaction, indexed by a compare bitmask with
+// one bit per lane. Each entry moves the passing lanes to the front.
+struct CompactTables {
+    alignas(32) uint32_t lanes32x8[256][8]; // AVX2 lane permutation, 32-bit lanes
+    alignas(32) uint32_t lanes64x4[16][8];  // AVX2 lane permutation, 64-bit lanes
+    alignas(16) uint8_t bytes32x4[16][16];  // Byte shuffle, 32-bit lanes in 128 bits
+    uint64_t keepBytes[256];                // Lane i's bit as byte i (0 or 1)
+    uint8_t count[256];                     // Bits set
+
+    CompactTables() : lanes32x8(), lanes64x4(), bytes32x4(), keepBytes(), count() {
+        for (unsigned mask = 0; mask < 256; ++mask) {
+            unsigned kept = 0;
+            for (unsigned lane = 0; lane < 8; ++lane) {
+                if (!(mask & (1u << lane))) continue;
+                lanes32x8[mask][kept] = lane;
+                if (mask < 16) {
+                    lanes64x4[mask][2 * kept] = 2 * lane;
+                    lanes64x4[mask][2 * kept + 1] = 2 * lane + 1;
+                    for (unsigned byte = 0; byte < 4; ++byte) {
+                        bytes32x4[mask][4 * kept + byte] = static_cast<uint8_t>(4 * lane + byte);
+                    }
+                }
+                keepBytes[mask] |= uint64_t(1) << (8 * lane);
+                ++kept;
+            }
+            count[mask] = static_cast<uint8_t>(kept);
+        }
+    }
+};
+
+inline const CompactTables& compactTables() {
+    static const CompactTables tables;
+    return tables;
+}
+
+// keep[] is copied straight out of keepBytes, which assumes lane i is byte
+// i in memory; every target with a vector path here is little-endian
+inline void storeKeep(uint8_t* keep, const CompactTables& tables, unsigned mask, size_t lanes) {
+    std::memcpy(keep, &tables.keepBytes[mask], lanes);
+}
+
+#if defined(SDPF_SIMD_X86)
+
+// ---- AVX2 ----
+
+SDPF_SIMD_TARGET("avx2")
+inline void multiplyAvx2(const int32_t* in, int32_t* out, size_t n, int32_t factor) {
+    const __m256i f = _mm256_set1_epi32(factor);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_mullo_epi32(v, f));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline void multiplyAvx2(const float* in, float* out, size_t n, float factor) {
+    const __m256 f = _mm256_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(in + i), f));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline void multiplyAvx2(const double* in, double* out, size_t n, double factor) {
+    const __m256d f = _mm256_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_mul_pd(_mm256_loadu_pd(in + i), f));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+// Amplification multiplies in double precision like the scalar path, then
+// truncates (ints) or rounds (floats) back to the element type
+SDPF_SIMD_TARGET("avx2")
+inline void amplifyAvx2(const int32_t* in, int32_t* out, size_t n, double gain) {
+    const __m256d g = _mm256_set1_pd(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m256d d = _mm256_mul_pd(_mm256_cvtepi32_pd(v), g);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvttpd_epi32(d));
+    }
+    amplifyScalar(in + i, out + i, n - i, gain);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline void amplifyAvx2(const float* in, float* out, size_t n, double gain) {
+    const __m256d g = _mm256_set1_pd(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d d = _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i)), g);
+        _mm_storeu_ps(out + i, _mm256_cvtpd_ps(d));
+    }
+    amplifyScalar(in + i, out + i, n - i, gain);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline void amplifyAvx2(const double* in, double* out, size_t n, double gain) {
+    multiplyAvx2(in, out, n, gain);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline void thresholdAvx2(const int32_t* in, int32_t* out, size_t n, int32_t threshold) {
+    const __m256i t = _mm256_set1_epi32(threshold);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i below = _mm256_cmpgt_epi32(t, v);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_andnot_si256(below, v));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline void thresholdAvx2(const float* in, float* out, size_t n, float threshold) {
+    const __m256 t = _mm256_set1_ps(threshold);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(in + i);
+        _mm256_storeu_ps(out + i, _mm256_and_ps(_mm256_cmp_ps(v, t, _CMP_GE_OQ), v));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline void thresholdAvx2(const double* in, double* out, size_t n, double threshold) {
+    const __m256d t = _mm256_set1_pd(threshold);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(in + i);
+        _mm256_storeu_pd(out + i, _mm256_and_pd(_mm256_cmp_pd(v, t, _CMP_GE_OQ), v));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+// Compaction permutes the passing lanes to the front and stores the
+// whole vector at the output cursor. The cursor never passes the input
+// position, so the full-width store stays inside the buffer and cannot
+// clobber input that has not been loaded yet.
+
+SDPF_SIMD_TARGET("avx2")
+inline size_t compactThresholdAvx2(const int32_t* in, int32_t* out, uint8_t* keep, size_t n,
+                                   int32_t threshold) {
+    const CompactTables& tables = compactTables();
+    const __m256i t = _mm256_set1_epi32(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i below = _mm256_cmpgt_epi32(t, v);
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(below))) & 0xFF;
+        __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(tables.lanes32x8[mask]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + kept), _mm256_permutevar8x32_epi32(v, perm));
+        storeKeep(keep + i, tables, mask, 8);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline size_t compactThresholdAvx2(const float* in, float* out, uint8_t* keep, size_t n,
+                                   float threshold) {
+    const CompactTables& tables = compactTables();
+    const __m256 t = _mm256_set1_ps(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(in + i);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_cmp_ps(v, t, _CMP_GE_OQ)));
+        __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(tables.lanes32x8[mask]));
+        _mm256_storeu_ps(out + kept, _mm256_permutevar8x32_ps(v, perm));
+        storeKeep(keep + i, tables, mask, 8);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("avx2")
+inline size_t compactThresholdAvx2(const double* in, double* out, uint8_t* keep, size_t n,
+                                   double threshold) {
+    const CompactTables& tables = compactTables();
+    const __m256d t = _mm256_set1_pd(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(in + i);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(v, t, _CMP_GE_OQ)));
+        __m256i perm = _mm256_load_si256(reinterpret_cast<const __m256i*>(tables.lanes64x4[mask]));
+        __m256 moved = _mm256_permutevar8x32_ps(_mm256_castpd_ps(v), perm);
+        _mm256_storeu_pd(out + kept, _mm256_castps_pd(moved));
+        storeKeep(keep + i, tables, mask, 4);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+// ---- SSE (SSE2, plus SSE4.1 for 32-bit integer multiply) ----
+
+SDPF_SIMD_TARGET("sse4.1")
+inline void multiplySse(const int32_t* in, int32_t* out, size_t n, int32_t factor) {
+    const __m128i f = _mm_set1_epi32(factor);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_mullo_epi32(v, f));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void multiplySse(const float* in, float* out, size_t n, float factor) {
+    const __m128 f = _mm_set1_ps(factor);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_loadu_ps(in + i), f));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void multiplySse(const double* in, double* out, size_t n, double factor) {
+    const __m128d f = _mm_set1_pd(factor);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm_storeu_pd(out + i, _mm_mul_pd(_mm_loadu_pd(in + i), f));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void amplifySse(const int32_t* in, int32_t* out, size_t n, double gain) {
+    const __m128d g = _mm_set1_pd(gain);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+        __m128d d = _mm_mul_pd(_mm_cvtepi32_pd(v), g);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_cvttpd_epi32(d));
+    }
+    amplifyScalar(in + i, out + i, n - i, gain);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void amplifySse(const float* in, float* out, size_t n, double gain) {
+    const __m128d g = _mm_set1_pd(gain);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(in + i);
+        __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(v), g));
+        __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), g));
+        _mm_storeu_ps(out + i, _mm_movelh_ps(lo, hi));
+    }
+    amplifyScalar(in + i, out + i, n - i, gain);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void amplifySse(const double* in, double* out, size_t n, double gain) {
+    multiplySse(in, out, n, gain);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void thresholdSse(const int32_t* in, int32_t* out, size_t n, int32_t threshold) {
+    const __m128i t = _mm_set1_epi32(threshold);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i below = _mm_cmpgt_epi32(t, v);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_andnot_si128(below, v));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void thresholdSse(const float* in, float* out, size_t n, float threshold) {
+    const __m128 t = _mm_set1_ps(threshold);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(in + i);
+        _mm_storeu_ps(out + i, _mm_and_ps(_mm_cmpge_ps(v, t), v));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("sse2")
+inline void thresholdSse(const double* in, double* out, size_t n, double threshold) {
+    const __m128d t = _mm_set1_pd(threshold);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(in + i);
+        _mm_storeu_pd(out + i, _mm_and_pd(_mm_cmpge_pd(v, t), v));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+// Compaction needs a variable byte shuffle (SSSE3, implied by SSE4.1)
+
+SDPF_SIMD_TARGET("ssse3")
+inline size_t compactThresholdSse(const int32_t* in, int32_t* out, uint8_t* keep, size_t n,
+                                  int32_t threshold) {
+    const CompactTables& tables = compactTables();
+    const __m128i t = _mm_set1_epi32(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i below = _mm_cmpgt_epi32(t, v);
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(below))) & 0xF;
+        __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.bytes32x4[mask]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + kept), _mm_shuffle_epi8(v, shuffle));
+        storeKeep(keep + i, tables, mask, 4);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("ssse3")
+inline size_t compactThresholdSse(const float* in, float* out, uint8_t* keep, size_t n,
+                                  float threshold) {
+    const CompactTables& tables = compactTables();
+    const __m128 t = _mm_set1_ps(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(in + i);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_cmpge_ps(v, t)));
+        __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.bytes32x4[mask]));
+        __m128i moved = _mm_shuffle_epi8(_mm_castps_si128(v), shuffle);
+        _mm_storeu_ps(out + kept, _mm_castsi128_ps(moved));
+        storeKeep(keep + i, tables, mask, 4);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+SDPF_SIMD_TARGET("ssse3")
+inline size_t compactThresholdSse(const double* in, double* out, uint8_t* keep, size_t n,
+                                  double threshold) {
+    const CompactTables& tables = compactTables();
+    const __m128d t = _mm_set1_pd(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(in + i);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_pd(_mm_cmpge_pd(v, t)));
+        // A 64-bit lane is a pair of 32-bit lanes in the shuffle table
+        unsigned pairs = ((mask & 1) ? 0x3u : 0u) | ((mask & 2) ? 0xCu : 0u);
+        __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(tables.bytes32x4[pairs]));
+        __m128i moved = _mm_shuffle_epi8(_mm_castpd_si128(v), shuffle);
+        _mm_storeu_pd(out + kept, _mm_castsi128_pd(moved));
+        storeKeep(keep + i, tables, mask, 2);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+#elif defined(SDPF_SIMD_NEON)
+
+// ---- NEON (AArch64) ----
+
+inline void multiplyNeon(const int32_t* in, int32_t* out, size_t n, int32_t factor) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_s32(out + i, vmulq_n_s32(vld1q_s32(in + i), factor));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+inline void multiplyNeon(const float* in, float* out, size_t n, float factor) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(out + i, vmulq_n_f32(vld1q_f32(in + i), factor));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+inline void multiplyNeon(const double* in, double* out, size_t n, double factor) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        vst1q_f64(out + i, vmulq_n_f64(vld1q_f64(in + i), factor));
+    }
+    multiplyScalar(in + i, out + i, n - i, factor);
+}
+
+inline void amplifyNeon(const int32_t* in, int32_t* out, size_t n, double gain) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t d = vcvtq_f64_s64(vmovl_s32(vld1_s32(in + i)));
+        vst1_s32(out + i, vmovn_s64(vcvtq_s64_f64(vmulq_n_f64(d, gain))));
+    }
+    amplifyScalar(in + i, out + i, n - i, gain);
+}
+
+inline void amplifyNeon(const float* in, float* out, size_t n, double gain) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t d = vcvt_f64_f32(vld1_f32(in + i));
+        vst1_f32(out + i, vcvt_f32_f64(vmulq_n_f64(d, gain)));
+    }
+    amplifyScalar(in + i, out + i, n - i, gain);
+}
+
+inline void amplifyNeon(const double* in, double* out, size_t n, double gain) {
+    multiplyNeon(in, out, n, gain);
+}
+
+inline void thresholdNeon(const int32_t* in, int32_t* out, size_t n, int32_t threshold) {
+    const int32x4_t t = vdupq_n_s32(threshold);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(in + i);
+        vst1q_s32(out + i, vandq_s32(v, vreinterpretq_s32_u32(vcgeq_s32(v, t))));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+inline void thresholdNeon(const float* in, float* out, size_t n, float threshold) {
+    const float32x4_t t = vdupq_n_f32(threshold);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(in + i);
+        uint32x4_t kept = vandq_u32(vreinterpretq_u32_f32(v), vcgeq_f32(v, t));
+        vst1q_f32(out + i, vreinterpretq_f32_u32(kept));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+inline void thresholdNeon(const double* in, double* out, size_t n, double threshold) {
+    const float64x2_t t = vdupq_n_f64(threshold);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vld1q_f64(in + i);
+        uint64x2_t kept = vandq_u64(vreinterpretq_u64_f64(v), vcgeq_f64(v, t));
+        vst1q_f64(out + i, vreinterpretq_f64_u64(kept));
+    }
+    thresholdScalar(in + i, out + i, n - i, threshold);
+}
+
+// Lane bits of a NEON compare result, lane i as bit i
+inline unsigned laneMask(uint32x4_t passed) {
+    const uint32x4_t bits = {1, 2, 4, 8};
+    return vaddvq_u32(vandq_u32(passed, bits));
+}
+
+inline size_t compactThresholdNeon(const int32_t* in, int32_t* out, uint8_t* keep, size_t n,
+                                   int32_t threshold) {
+    const CompactTables& tables = compactTables();
+    const int32x4_t t = vdupq_n_s32(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 4 <= n; i += 4) {
+        int32x4_t v = vld1q_s32(in + i);
+        unsigned mask = laneMask(vcgeq_s32(v, t));
+        uint8x16_t moved = vqtbl1q_u8(vreinterpretq_u8_s32(v), vld1q_u8(tables.bytes32x4[mask]));
+        vst1q_s32(out + kept, vreinterpretq_s32_u8(moved));
+        storeKeep(keep + i, tables, mask, 4);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+inline size_t compactThresholdNeon(const float* in, float* out, uint8_t* keep, size_t n,
+                                   float threshold) {
+    const CompactTables& tables = compactTables();
+    const float32x4_t t = vdupq_n_f32(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 4 <= n; i += 4) {
+        float32x4_t v = vld1q_f32(in + i);
+        unsigned mask = laneMask(vcgeq_f32(v, t));
+        uint8x16_t moved = vqtbl1q_u8(vreinterpretq_u8_f32(v), vld1q_u8(tables.bytes32x4[mask]));
+        vst1q_f32(out + kept, vreinterpretq_f32_u8(moved));
+        storeKeep(keep + i, tables, mask, 4);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+inline size_t compactThresholdNeon(const double* in, double* out, uint8_t* keep, size_t n,
+                                   double threshold) {
+    const CompactTables& tables = compactTables();
+    const float64x2_t t = vdupq_n_f64(threshold);
+    size_t i = 0;
+    size_t kept = 0;
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vld1q_f64(in + i);
+        uint64x2_t passed = vcgeq_f64(v, t);
+        unsigned mask = static_cast<unsigned>((vgetq_lane_u64(passed, 0) & 1) |
+                                              (vgetq_lane_u64(passed, 1) & 2));
+        unsigned pairs = ((mask & 1) ? 0x3u : 0u) | ((mask & 2) ? 0xCu : 0u);
+        uint8x16_t moved = vqtbl1q_u8(vreinterpretq_u8_f64(v), vld1q_u8(tables.bytes32x4[pairs]));
+        vst1q_f64(out + kept, vreinterpretq_f64_u8(moved));
+        storeKeep(keep + i, tables, mask, 2);
+        kept += tables.count[mask];
+    }
+    return kept + compactThresholdScalar(in + i, out + kept, keep + i, n - i, threshold);
+}
+
+#endif
+
+} // namespace detail
+
+// ============ DISPATCHING ENTRY POINTS ============
+
+// out[i] = in[i] * factor
+template<typename T>
+void multiply(const T* in, T* out, size_t n, T factor) {
+    static_assert(IsVectorizable<T>::value, "No SIMD kernel for this type");
+    switch (activeLevel()) {
+#if defined(SDPF_SIMD_X86)
+    case Level::AVX2: return detail::multiplyAvx2(in, out, n, factor);
+    case Level::SSE: return detail::multiplySse(in, out, n, factor);
+#elif defined(SDPF_SIMD_NEON)
+    case Level::NEON: return detail::multiplyNeon(in, out, n, factor);
+#endif
+    default: return multiplyScalar(in, out, n, factor);
+    }
+}
+
+// out[i] = static_cast<T>(in[i] * gain)
+template<typename T>
+void amplify(const T* in, T* out, size_t n, double gain) {
+    static_assert(IsVectorizable<T>::value, "No SIMD kernel for this type");
+    switch (activeLevel()) {
+#if defined(SDPF_SIMD_X86)
+    case Level::AVX2: return detail::amplifyAvx2(in, out, n, gain);
+    case Level::SSE: return detail::amplifySse(in, out, n, gain);
+#elif defined(SDPF_SIMD_NEON)
+    case Level::NEON: return detail::amplifyNeon(in, out, n, gain);
+#endif
+    default: return amplifyScalar(in, out, n, gain);
+    }
+}
+
+// out[i] = in[i] >= threshold ? in[i] : T()
+template<typename T>
+void threshold(const T* in, T* out, size_t n, T threshold) {
+    static_assert(IsVectorizable<T>::value, "No SIMD kernel for this type");
+    switch (activeLevel()) {
+#if defined(SDPF_SIMD_X86)
+    case Level::AVX2: return detail::thresholdAvx2(in, out, n, threshold);
+    case Level::SSE: return detail::thresholdSse(in, out, n, threshold);
+#elif defined(SDPF_SIMD_NEON)
+    case Level::NEON: return detail::thresholdNeon(in, out, n, threshold);
+#endif
+    default: return thresholdScalar(in, out, n, threshold);
+    }
+}
+
+// Stream compaction: the items with in[i] >= threshold, in order, at the
+// front of out; keep[i] is 1 for those and 0 for the rest. Returns how
+// many were kept. out may alias in; out[kept..n) is left unspecified.
+template<typename T>
+size_t compactThreshold(const T* in, T* out, uint8_t* keep, size_t n, T threshold) {
+    static_assert(IsVectorizable<T>::value, "No SIMD kernel for this type");
+    switch (activeLevel()) {
+#if defined(SDPF_SIMD_X86)
+    case Level::AVX2: return detail::compactThresholdAvx2(in, out, keep, n, threshold);
+    case Level::SSE: return detail::compactThresholdSse(in, out, keep, n, threshold);
+#elif defined(SDPF_SIMD_NEON)
+    case Level::NEON: return detail::compactThresholdNeon(in, out, keep, n, threshold);
+#endif
+    default: return compactThresholdScalar(in, out, keep, n, threshold);
+    }
+}
+
+} // namespace simd
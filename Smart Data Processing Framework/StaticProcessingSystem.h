@@ -0,0 +1,307 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include <cstdint>
+
+#include "ProcessingSystem.h"
+#include "Processor.h"
+#include "Checkpoint.h"
+
+// ============ COMPILE-TIME STAGES ============
+//
+// A static stage is a plain class with
+//   bool apply(T& value)       transform value in place; false drops it
+//   bool drops() const         whether apply() can ever return false
+//   bool stateless() const     whether it may run on several workers at once
+//   std::string name() const
+//   void reset()
+//   bool snapshot(ByteWriter&) const, bool restore(ByteReader&)
+//                              save and load state, as Processor does
+// No virtual calls are involved, so a chain of stages inlines into one
+// loop body that the compiler can vectorize and constant-fold.
+
+// Stage parameter fixed at compile time: Constant<3> is 3, Constant<3, 2> is 1.5
+template<long long Num, long long Den = 1>
+struct Constant {
+    static constexpr double value = static_cast<double>(Num) / static_cast<double>(Den);
+};
+
+// Defaults for the optional parts of the stage interface. Stages derived
+// from it must also be pure: apply() depends on nothing but its argument.
+struct StaticStage {
+    bool drops() const { return false; }
+    bool stateless() const { return true; }
+    void reset() {}
+    bool snapshot(ByteWriter&) const { return true; }
+    bool restore(ByteReader&) { return true; }
+};
+
+// value * Factor, as NumericProcessor
+template<typename T, typename Factor>
+struct Multiply : StaticStage {
+    bool apply(T& value) const {
+        value = value * static_cast<T>(Factor::value);
+        return true;
+    }
+
+    std::string name() const { return "Multiply"; }
+};
+
+// value * Gain, as AmplificationProcessor
+template<typename T, typename Gain>
+struct Amplify : StaticStage {
+    bool apply(T& value) const {
+        value = static_cast<T>(value * Gain::value);
+        return true;
+    }
+
+    std::string name() const { return "Amplify"; }
+};
+
+// Keeps values >= Min, as FilteringProcessor inside a ProcessingSystem
+template<typename T, typename Min>
+struct Threshold : StaticStage {
+    bool apply(const T& value) const {
+        return value >= static_cast<T>(Min::value);
+    }
+
+    bool drops() const { return true; }
+
+    std::string name() const { return "Threshold"; }
+};
+
+// Runs a concrete Processor (held by value) as a stage. Calls are
+// qualified with P, so they bind statically and can be inlined; use it
+// for stages whose parameters are only known at run time.
+template<typename P>
+class ProcessorStage {
+public:
+    template<typename... Args>
+    explicit ProcessorStage(Args&&... args) : processor_(std::forward<Args>(args)...) {}
+
+    template<typename T>
+    bool apply(T& value) {
+        if (!processor_.P::dropsItems()) {
+            value = processor_.P::process(value);
+            return true;
+        }
+        std::optional<T> result = processor_.P::tryProcess(value);
+        if (!result) return false;
+        value = std::move(*result);
+        return true;
+    }
+
+    bool drops() const { return processor_.P::dropsItems(); }
+    bool stateless() const { return processor_.P::isStateless(); }
+    std::string name() const { return processor_.P::getName(); }
+    void reset() { processor_.P::reset(); }
+    bool snapshot(ByteWriter& out) const { return processor_.P::snapshot(out); }
+    bool restore(ByteReader& in) { return processor_.P::restore(in); }
+
+    P& processor() { return processor_; }
+
+private:
+    P processor_;
+};
+
+// ============ STATIC CHAIN ============
+
+// The stages as one Processor. Workers still reach it through one virtual
+// processBatch()/processBatchFiltered() call per batch, but everything
+// inside the batch loop is resolved at compile time.
+template<typename T, typename... Stages>
+class StaticChain final : public Processor<T> {
+    static_assert(sizeof...(Stages) > 0, "StaticChain needs at least one stage");
+
+public:
+    explicit StaticChain(Stages... stages) : stages_(std::move(stages)...) {
+        std::apply([this](auto&... stage) {
+            drops_ = (stage.drops() || ...);
+            stateless_ = (stage.stateless() && ...);
+        }, stages_);
+    }
+
+    StaticChain() : StaticChain(Stages()...) {}
+
+    T process(const T& input) override {
+        T value = input;
+        return applyAll(value) ? value : T();
+    }
+
+    std::optional<T> tryProcess(const T& input) override {
+        T value = input;
+        if (!applyAll(value)) return std::nullopt;
+        return value;
+    }
+
+    void processBatch(const T* in, T* out, size_t n) override {
+        size_t blocked = 0;
+        if constexpr (kVectorizable) {
+            // Whole blocks go through a local buffer: it cannot alias in or
+            // out and has a fixed trip count, so even -O2 vectorizes the loop
+            blocked = n - n % kBlockSize;
+            T block[kBlockSize];
+            for (size_t start = 0; start < blocked; start += kBlockSize) {
+                for (size_t j = 0; j < kBlockSize; ++j) {
+                    T value = in[start + j];
+                    block[j] = applyAll(value) ? value : T();
+                }
+                std::copy(block, block + kBlockSize, out + start);
+            }
+        }
+        for (size_t i = blocked; i < n; ++i) {
+            T value = in[i];
+            out[i] = applyAll(value) ? std::move(value) : T();
+        }
+    }
+
+    void processInPlace(T& value) override {
+        if (!applyAll(value)) value = T();
+    }
+
+    bool processesInPlace() const override {
+        return !drops_;
+    }
+
+    bool dropsItems() const override {
+        return drops_;
+    }
+
+    size_t processBatchFiltered(const T* in, T* out, uint8_t* keep, size_t n) override {
+        size_t kept = 0;
+        for (size_t i = 0; i < n; ++i) {
+            T value = in[i];
+            bool pass = applyAll(value);
+            keep[i] = pass ? 1 : 0;
+            if constexpr (std::is_trivially_copyable_v<T>) {
+                // Branch-free: always write, only advance when kept.
+                // kept <= i, so this never overwrites an unread input.
+                out[kept] = value;
+                kept += pass ? 1 : 0;
+            } else if (pass) {
+                out[kept++] = std::move(value);
+            }
+        }
+        return kept;
+    }
+
+    std::string getName() const override {
+        std::string name;
+        std::apply([&name](const auto&... stage) {
+            ((name += (name.empty() ? "" : " -> ") + stage.name()), ...);
+        }, stages_);
+        return "Static[" + name + "]";
+    }
+
+    std::shared_ptr<Processor<T>> clone() const override {
+        return std::make_shared<StaticChain>(*this);
+    }
+
+    void reset() override {
+        std::apply([](auto&... stage) { (stage.reset(), ...); }, stages_);
+        Processor<T>::reset();
+    }
+
+    bool isStateless() const override {
+        return stateless_;
+    }
+
+    // Stage by stage, in chain order
+    bool snapshot(ByteWriter& out) const override {
+        return std::apply([&out](const auto&... stage) {
+            return (stage.snapshot(out) && ...);
+        }, stages_);
+    }
+
+    bool restore(ByteReader& in) override {
+        return std::apply([&in](auto&... stage) {
+            return (stage.restore(in) && ...);
+        }, stages_);
+    }
+
+    bool isPure() const override {
+        return kPure;
+    }
+
+    template<size_t I>
+    auto& stage() {
+        return std::get<I>(stages_);
+    }
+
+private:
+    static constexpr bool kPure = (std::is_base_of_v<StaticStage, Stages> && ...);
+    static constexpr bool kVectorizable = kPure && std::is_trivially_copyable_v<T>;
+    static constexpr size_t kBlockSize = 64;
+
+    // Stops at the first stage that drops the value. Pure stages of a
+    // trivially copyable T all run regardless, which costs nothing and
+    // leaves a branch-free loop body the compiler can vectorize. The comma
+    // fold keeps the stages in order; & alone would not sequence them.
+    bool applyAll(T& value) {
+        return std::apply([&value](auto&... stage) {
+            if constexpr (kVectorizable) {
+                bool kept = true;
+                ((kept &= static_cast<bool>(stage.apply(value))), ...);
+                return kept;
+            } else {
+                return (stage.apply(value) && ...);
+            }
+        }, stages_);
+    }
+
+    std::tuple<Stages...> stages_;
+    bool drops_ = false;
+    bool stateless_ = true;
+};
+
+// ============ STATIC PROCESSING SYSTEM ============
+
+// ProcessingSystem whose processor chain is fixed at compile time, e.g.
+//
+//   StaticProcessingSystem<double,
+//       Multiply<double, Constant<3>>,
+//       Threshold<double, Constant<0>>> system(4, 1000);
+//
+// Everything else (queues, scheduling modes, ordering, sinks, metrics)
+// is the ordinary ProcessingSystem. Use ProcessingSystem with the
+// factory when the chain is only known at run time.
+template<typename T, template<typename> class QueueT, typename... Stages>
+class BasicStaticProcessingSystem : public ProcessingSystem<T, QueueT> {
+public:
+    using Chain = StaticChain<T, Stages...>;
+
+    explicit BasicStaticProcessingSystem(size_t numWorkers = 4, size_t queueSize = 10000)
+        : BasicStaticProcessingSystem(numWorkers, queueSize, Stages()...) {}
+
+    // For stages that take constructor arguments
+    BasicStaticProcessingSystem(size_t numWorkers, size_t queueSize, Stages... stages)
+        : ProcessingSystem<T, QueueT>(numWorkers, queueSize),
+          chain_(std::make_shared<Chain>(std::move(stages)...)) {
+        ProcessingSystem<T, QueueT>::setProcessor(chain_);
+    }
+
+    // The chain the workers run. Touching a stateful stage while running
+    // needs the same care as any shared processor.
+    Chain& chain() {
+        return *chain_;
+    }
+
+private:
+    // The chain is part of the type
+    using ProcessingSystem<T, QueueT>::setProcessor;
+    using ProcessingSystem<T, QueueT>::setProcessorByType;
+#if SDPF_HAS_COROUTINES
+    using ProcessingSystem<T, QueueT>::setAsyncProcessor;
+#endif
+
+    std::shared_ptr<Chain> chain_;
+};
+
+template<typename T, typename... Stages>
+using StaticProcessingSystem = BasicStaticProcessingSystem<T, DataQueue, Stages...>;
@@ -0,0 +1,203 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOGDI
+#define NOGDI // wingdi.h defines ERROR, which breaks LOG_ERROR
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+// CPUs grouped by NUMA node, as far as the platform tells us. Only CPUs
+// this process may run on are listed. Detected from sysfs on Linux;
+// elsewhere, and when sysfs is unavailable, every CPU is put on a
+// single node.
+class CpuTopology {
+public:
+    struct Node {
+        int id = 0;
+        std::vector<int> cpus;
+    };
+
+    static CpuTopology detect() {
+        std::vector<Node> nodes;
+        std::vector<int> allowed = allowedCpus();
+#if defined(__linux__)
+        for (int id = 0; id < kMaxNodes; ++id) {
+            std::ifstream list("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            if (!list) continue;
+            std::string text;
+            std::getline(list, text);
+            Node node;
+            node.id = id;
+            for (int cpu : parseCpuList(text)) {
+                if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                    node.cpus.push_back(cpu);
+                }
+            }
+            if (!node.cpus.empty()) {
+                nodes.push_back(std::move(node));
+            }
+        }
+#endif
+        if (nodes.empty()) {
+            nodes.push_back(Node{0, allowed});
+        }
+        return CpuTopology(std::move(nodes));
+    }
+
+    // Build a topology by hand, e.g. to test placement
+    explicit CpuTopology(std::vector<Node> nodes = {}) : nodes_(std::move(nodes)) {
+        for (size_t i = 0; i < nodes_.size(); ++i) {
+            for (int cpu : nodes_[i].cpus) {
+                if (cpu < 0) continue;
+                if (static_cast<size_t>(cpu) >= nodeIndex_.size()) nodeIndex_.resize(cpu + 1, 0);
+                nodeIndex_[cpu] = i;
+            }
+        }
+    }
+
+    const std::vector<Node>& nodes() const {
+        return nodes_;
+    }
+
+    size_t cpuCount() const {
+        size_t count = 0;
+        for (const auto& node : nodes_) count += node.cpus.size();
+        return count;
+    }
+
+    // Index into nodes() of the node holding cpu, or 0 if unknown
+    size_t nodeIndexOf(int cpu) const {
+        return cpu >= 0 && static_cast<size_t>(cpu) < nodeIndex_.size() ? nodeIndex_[cpu] : 0;
+    }
+
+    // "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+    static std::vector<int> parseCpuList(const std::string& text) {
+        std::vector<int> cpus;
+        std::stringstream ss(text);
+        std::string range;
+        while (std::getline(ss, range, ',')) {
+            if (range.empty() || range.find_first_not_of(" \n") == std::string::npos) continue;
+            size_t dash = range.find('-');
+            try {
+                int first = std::stoi(range.substr(0, dash));
+                int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+            } catch (const std::exception&) {
+                // Malformed entry: skip it
+            }
+        }
+        return cpus;
+    }
+
+private:
+    static constexpr int kMaxNodes = 1024;
+
+    static std::vector<int> allowedCpus() {
+        std::vector<int> cpus;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+            }
+        }
+#endif
+        if (cpus.empty()) {
+            unsigned count = std::max(std::thread::hardware_concurrency(), 1u);
+            for (unsigned cpu = 0; cpu < count; ++cpu) cpus.push_back(static_cast<int>(cpu));
+        }
+        return cpus;
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<size_t> nodeIndex_; // By CPU number
+};
+
+// Restrict the calling thread to one CPU. Returns false where pinning is
+// unsupported or the CPU is not available.
+inline bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+    if (cpu < 0 || cpu >= 64) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// CPU the calling thread is running on, or -1 if unknown
+inline int currentCpu() {
+#if defined(__linux__)
+    return sched_getcpu();
+#elif defined(_WIN32)
+    return static_cast<int>(GetCurrentProcessorNumber());
+#else
+    return -1;
+#endif
+}
+
+// Run fn on a thread pinned to cpu and wait for it. Memory fn touches
+// first is then placed on that CPU's node by the first-touch policy.
+template<typename Fn>
+void runPinned(int cpu, Fn&& fn) {
+    std::thread thread([cpu, &fn] {
+        pinCurrentThread(cpu);
+        fn();
+    });
+    thread.join();
+}
+
+// How workers are placed on CPUs
+enum class PlacementPolicy {
+    NONE,    // Leave it to the OS scheduler
+    COMPACT, // Fill one node's CPUs before moving to the next
+    SPREAD   // Deal workers round-robin over the nodes
+};
+
+// CPU for each of count workers under policy
+inline std::vector<int> assignCpus(const CpuTopology& topology, PlacementPolicy policy,
+                                   size_t count) {
+    std::vector<int> cpus;
+    const auto& nodes = topology.nodes();
+    if (policy == PlacementPolicy::NONE || topology.cpuCount() == 0) return cpus;
+
+    if (policy == PlacementPolicy::COMPACT) {
+        std::vector<int> all;
+        for (const auto& node : nodes) all.insert(all.end(), node.cpus.begin(), node.cpus.end());
+        for (size_t i = 0; i < count; ++i) cpus.push_back(all[i % all.size()]);
+        return cpus;
+    }
+
+    std::vector<size_t> used(nodes.size(), 0);
+    for (size_t node = 0; cpus.size() < count; node = (node + 1) % nodes.size()) {
+        if (nodes[node].cpus.empty()) continue;
+        cpus.push_back(nodes[node].cpus[used[node]++ % nodes[node].cpus.size()]);
+    }
+    return cpus;
+}
@@ -0,0 +1,516 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <optional>
+
+#include "Processor.h"
+#include "Metrics.h"
+
+// Aggregate of one closed window. Values are accumulated in double, so
+// integer input neither truncates nor overflows.
+struct WindowResult {
+    uint64_t windowId = 0;
+    int64_t startNs = 0;  // Time windows: [startNs, endNs); count windows: arrival times
+    int64_t endNs = 0;
+    uint64_t count = 0;
+    double sum = 0.0;
+    double mean = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double variance = 0.0; // Population variance
+};
+
+enum class WindowKind {
+    TUMBLING, // Back-to-back, non-overlapping windows
+    SLIDING,  // Windows of `size` emitted every `slide`
+    SESSION   // Closes once no item arrived for `gap`
+};
+
+// Window shape. Sizes are item counts for count windows and nanoseconds
+// for time windows.
+struct WindowSpec {
+    WindowKind kind = WindowKind::TUMBLING;
+    bool timeBased = false;
+    uint64_t size = 0;
+    uint64_t slide = 0;
+
+    static WindowSpec tumblingCount(uint64_t items) {
+        return {WindowKind::TUMBLING, false, std::max<uint64_t>(items, 1), 0};
+    }
+
+    static WindowSpec tumblingTime(std::chrono::nanoseconds length) {
+        return {WindowKind::TUMBLING, true, clampNs(length), 0};
+    }
+
+    static WindowSpec slidingCount(uint64_t items, uint64_t every) {
+        return {WindowKind::SLIDING, false, std::max<uint64_t>(items, 1),
+                std::max<uint64_t>(every, 1)};
+    }
+
+    static WindowSpec slidingTime(std::chrono::nanoseconds length, std::chrono::nanoseconds every) {
+        return {WindowKind::SLIDING, true, clampNs(length), clampNs(every)};
+    }
+
+    static WindowSpec session(std::chrono::nanoseconds gap) {
+        return {WindowKind::SESSION, true, clampNs(gap), 0};
+    }
+
+private:
+    static uint64_t clampNs(std::chrono::nanoseconds value) {
+        return value.count() > 0 ? static_cast<uint64_t>(value.count()) : 1;
+    }
+};
+
+// Count, sum, mean and variance with O(1) insert and remove (Welford's
+// update run forwards and backwards)
+class RunningStats {
+public:
+    void add(double x) {
+        ++count_;
+        sum_ += x;
+        double delta = x - mean_;
+        mean_ += delta / static_cast<double>(count_);
+        m2_ += delta * (x - mean_);
+    }
+
+    void remove(double x) {
+        if (count_ <= 1) {
+            clear();
+            return;
+        }
+        --count_;
+        sum_ -= x;
+        double delta = x - mean_;
+        mean_ -= delta / static_cast<double>(count_);
+        m2_ -= delta * (x - mean_);
+        if (m2_ < 0.0) m2_ = 0.0; // Rounding
+    }
+
+    void clear() {
+        count_ = 0;
+        sum_ = mean_ = m2_ = 0.0;
+    }
+
+    uint64_t count() const { return count_; }
+    double sum() const { return sum_; }
+    double mean() const { return mean_; }
+    double variance() const { return count_ ? m2_ / static_cast<double>(count_) : 0.0; }
+
+    void save(ByteWriter& out) const {
+        out.writeVarint(count_);
+        out.write(sum_);
+        out.write(mean_);
+        out.write(m2_);
+    }
+
+    bool load(ByteReader& in) {
+        return in.readVarint(count_) && in.read(sum_) && in.read(mean_) && in.read(m2_);
+    }
+
+private:
+    uint64_t count_ = 0;
+    double sum_ = 0.0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+};
+
+// FIFO that reports its min and max in O(1) amortized time (two-stacks
+// queue: each stack entry carries the min/max of everything below it)
+class MinMaxQueue {
+public:
+    struct Entry {
+        double value;
+        int64_t timeNs;
+    };
+
+    void push(double value, int64_t timeNs) {
+        back_.push_back(Node{Entry{value, timeNs}, value, value});
+        if (back_.size() > 1) {
+            Node& node = back_.back();
+            const Node& below = back_[back_.size() - 2];
+            node.min = std::min(node.min, below.min);
+            node.max = std::max(node.max, below.max);
+        }
+    }
+
+    Entry pop() {
+        if (front_.empty()) {
+            // Reverse the back stack onto the front, rebuilding aggregates
+            while (!back_.empty()) {
+                double value = back_.back().entry.value;
+                Node node{back_.back().entry, value, value};
+                if (!front_.empty()) {
+                    node.min = std::min(node.min, front_.back().min);
+                    node.max = std::max(node.max, front_.back().max);
+                }
+                front_.push_back(node);
+                back_.pop_back();
+            }
+        }
+        Entry entry = front_.back().entry;
+        front_.pop_back();
+        return entry;
+    }
+
+    const Entry& front() const {
+        return front_.empty() ? back_.front().entry : front_.back().entry;
+    }
+
+    bool empty() const { return front_.empty() && back_.empty(); }
+    size_t size() const { return front_.size() + back_.size(); }
+
+    double min() const {
+        if (front_.empty()) return back_.back().min;
+        if (back_.empty()) return front_.back().min;
+        return std::min(front_.back().min, back_.back().min);
+    }
+
+    double max() const {
+        if (front_.empty()) return back_.back().max;
+        if (back_.empty()) return front_.back().max;
+        return std::max(front_.back().max, back_.back().max);
+    }
+
+    void clear() {
+        front_.clear();
+        back_.clear();
+    }
+
+    // Entries oldest first; load() rebuilds the aggregates by pushing
+    void save(ByteWriter& out) const {
+        out.writeVarint(size());
+        for (auto it = front_.rbegin(); it != front_.rend(); ++it) {
+            out.write(it->entry);
+        }
+        for (const auto& node : back_) {
+            out.write(node.entry);
+        }
+    }
+
+    bool load(ByteReader& in) {
+        clear();
+        uint64_t n;
+        if (!in.readCount(n, sizeof(Entry))) return false;
+        for (uint64_t i = 0; i < n; ++i) {
+            Entry entry;
+            if (!in.read(entry)) return false;
+            push(entry.value, entry.timeNs);
+        }
+        return true;
+    }
+
+private:
+    struct Node {
+        Entry entry;
+        double min;
+        double max;
+    };
+
+    std::vector<Node> front_; // Top is the oldest entry
+    std::vector<Node> back_;  // Top is the newest entry
+};
+
+// Windowed aggregation over a numeric stream. Every item costs O(1)
+// regardless of window size; each closed window produces one
+// WindowResult. Closed windows from one batch are emitted together
+// through the callback. Items pass through process() unchanged, so the
+// processor can also sit in front of other stages; as the last stage,
+// setPassThrough(false) drops them once they are aggregated.
+//
+// Time windows use arrival time by default; pass a timestamp function
+// for event time. Stateful: the ProcessingSystem serializes it, or
+// partitioned mode gives every key its own clone.
+template<typename T>
+class WindowedAggregationProcessor : public Processor<T> {
+public:
+    using EmitCallback = std::function<void(std::vector<WindowResult>&)>;
+    using TimestampFn = std::function<int64_t(const T&)>;
+
+    WindowedAggregationProcessor(WindowSpec spec, EmitCallback onWindows,
+                                 TimestampFn timestamp = nullptr)
+        : spec_(spec), onWindows_(std::move(onWindows)), timestamp_(std::move(timestamp)) {}
+
+    T process(const T& input) override {
+        accumulate(input);
+        emitPending();
+        return input;
+    }
+
+    void processBatch(const T* in, T* out, size_t n) override {
+        for (size_t i = 0; i < n; ++i) {
+            accumulate(in[i]);
+            out[i] = in[i];
+        }
+        emitPending(); // One emission per batch, however many windows closed
+    }
+
+    // Whether items are forwarded after aggregation (the default) or
+    // dropped, leaving the window results as the only output
+    void setPassThrough(bool passThrough) {
+        passThrough_ = passThrough;
+    }
+
+    bool dropsItems() const override {
+        return !passThrough_;
+    }
+
+    std::optional<T> tryProcess(const T& input) override {
+        if (passThrough_) {
+            return process(input);
+        }
+        accumulate(input);
+        emitPending();
+        return std::nullopt;
+    }
+
+    size_t processBatchFiltered(const T* in, T* out, uint8_t* keep, size_t n) override {
+        if (passThrough_) {
+            processBatch(in, out, n);
+            std::fill(keep, keep + n, uint8_t(1));
+            return n;
+        }
+        for (size_t i = 0; i < n; ++i) {
+            accumulate(in[i]);
+        }
+        std::fill(keep, keep + n, uint8_t(0));
+        emitPending();
+        return 0;
+    }
+
+    // Close the open window (e.g. at end of stream) and emit it. Not
+    // synchronized with the workers: call it once input has drained.
+    void flush() {
+        if (spec_.kind != WindowKind::SLIDING) {
+            if (stats_.count() > 0) {
+                bool fixedEnd = spec_.kind == WindowKind::TUMBLING && spec_.timeBased;
+                closeWindow(windowStartNs_, fixedEnd ? windowEndNs_ : lastTimeNs_);
+            }
+        } else if (spec_.timeBased) {
+            if (!window_.empty()) {
+                closeSliding(nextEndNs_);
+                nextEndNs_ += static_cast<int64_t>(spec_.slide);
+            }
+        } else if (seen_ % spec_.slide != 0 && !window_.empty()) {
+            emitSliding(window_.front().timeNs, lastTimeNs_);
+            seen_ += spec_.slide - seen_ % spec_.slide;
+        }
+        emitPending();
+    }
+
+    std::string getName() const override {
+        return "WindowedAggregationProcessor";
+    }
+
+    std::shared_ptr<Processor<T>> clone() const override {
+        return std::make_shared<WindowedAggregationProcessor>(*this);
+    }
+
+    // Open windows and their position; the callbacks and spec come from
+    // the processor being restored into
+    bool snapshot(ByteWriter& out) const override {
+        stats_.save(out);
+        window_.save(out);
+        out.write(pending_);
+        out.write(min_);
+        out.write(max_);
+        out.write(windowStartNs_);
+        out.write(windowEndNs_);
+        out.write(nextEndNs_);
+        out.write(lastTimeNs_);
+        out.writeVarint(seen_);
+        out.writeVarint(nextWindowId_);
+        out.write(started_);
+        return true;
+    }
+
+    bool restore(ByteReader& in) override {
+        return stats_.load(in) && window_.load(in) && in.read(pending_) &&
+               in.read(min_) && in.read(max_) &&
+               in.read(windowStartNs_) && in.read(windowEndNs_) &&
+               in.read(nextEndNs_) && in.read(lastTimeNs_) &&
+               in.readVarint(seen_) && in.readVarint(nextWindowId_) && in.read(started_);
+    }
+
+    void reset() override {
+        stats_.clear();
+        window_.clear();
+        pending_.clear();
+        started_ = false;
+        seen_ = 0;
+        nextWindowId_ = 0;
+        Processor<T>::reset();
+    }
+
+private:
+    void accumulate(const T& input) {
+        double x = static_cast<double>(input);
+        int64_t now = timestamp_ ? timestamp_(input) : monotonicNanos();
+
+        switch (spec_.kind) {
+            case WindowKind::TUMBLING:
+                spec_.timeBased ? addTumblingTime(x, now) : addTumblingCount(x, now);
+                break;
+            case WindowKind::SLIDING:
+                spec_.timeBased ? addSlidingTime(x, now) : addSlidingCount(x, now);
+                break;
+            case WindowKind::SESSION:
+                addSession(x, now);
+                break;
+        }
+        lastTimeNs_ = now;
+    }
+
+    // Tumbling windows need no eviction: plain running min/max suffice
+    void addToTumbling(double x, int64_t now) {
+        if (stats_.count() == 0) {
+            min_ = max_ = x;
+            if (!spec_.timeBased) windowStartNs_ = now;
+        } else {
+            min_ = std::min(min_, x);
+            max_ = std::max(max_, x);
+        }
+        stats_.add(x);
+    }
+
+    void addTumblingCount(double x, int64_t now) {
+        addToTumbling(x, now);
+        if (stats_.count() >= spec_.size) {
+            closeWindow(windowStartNs_, now);
+        }
+    }
+
+    void addTumblingTime(double x, int64_t now) {
+        auto size = static_cast<int64_t>(spec_.size);
+        if (!started_ || now >= windowEndNs_) {
+            if (stats_.count() > 0) {
+                closeWindow(windowStartNs_, windowEndNs_);
+            }
+            windowStartNs_ = floorTo(now, size);
+            windowEndNs_ = windowStartNs_ + size;
+            started_ = true;
+        }
+        addToTumbling(x, now);
+    }
+
+    void addSession(double x, int64_t now) {
+        if (stats_.count() > 0 && now - lastTimeNs_ > static_cast<int64_t>(spec_.size)) {
+            closeWindow(windowStartNs_, lastTimeNs_);
+        }
+        if (stats_.count() == 0) {
+            windowStartNs_ = now;
+            min_ = max_ = x;
+        } else {
+            min_ = std::min(min_, x);
+            max_ = std::max(max_, x);
+        }
+        stats_.add(x);
+    }
+
+    // Last `size` items, emitted every `slide` items
+    void addSlidingCount(double x, int64_t now) {
+        window_.push(x, now);
+        stats_.add(x);
+        if (window_.size() > spec_.size) {
+            stats_.remove(window_.pop().value);
+        }
+        if (++seen_ % spec_.slide == 0) {
+            emitSliding(window_.front().timeNs, now);
+        }
+    }
+
+    // Windows [end - size, end) for every end on a multiple of `slide`
+    void addSlidingTime(double x, int64_t now) {
+        auto slide = static_cast<int64_t>(spec_.slide);
+        if (!started_) {
+            nextEndNs_ = floorTo(now, slide) + slide;
+            started_ = true;
+        }
+        while (now >= nextEndNs_) {
+            closeSliding(nextEndNs_);
+            if (window_.empty()) {
+                // Idle stretch: skip the empty windows in between
+                nextEndNs_ = floorTo(now, slide) + slide;
+                break;
+            }
+            nextEndNs_ += slide;
+        }
+        window_.push(x, now);
+        stats_.add(x);
+    }
+
+    void closeSliding(int64_t endNs) {
+        int64_t startNs = endNs - static_cast<int64_t>(spec_.size);
+        while (!window_.empty() && window_.front().timeNs < startNs) {
+            stats_.remove(window_.pop().value);
+        }
+        if (!window_.empty()) {
+            emitSliding(startNs, endNs);
+        }
+    }
+
+    void emitSliding(int64_t startNs, int64_t endNs) {
+        WindowResult result = snapshot(startNs, endNs);
+        result.min = window_.min();
+        result.max = window_.max();
+        pending_.push_back(result);
+    }
+
+    // Emit and clear a tumbling or session window
+    void closeWindow(int64_t startNs, int64_t endNs) {
+        WindowResult result = snapshot(startNs, endNs);
+        result.min = min_;
+        result.max = max_;
+        pending_.push_back(result);
+        stats_.clear();
+    }
+
+    WindowResult snapshot(int64_t startNs, int64_t endNs) {
+        WindowResult result;
+        result.windowId = nextWindowId_++;
+        result.startNs = startNs;
+        result.endNs = endNs;
+        result.count = stats_.count();
+        result.sum = stats_.sum();
+        result.mean = stats_.mean();
+        result.variance = stats_.variance();
+        return result;
+    }
+
+    void emitPending() {
+        if (pending_.empty()) return;
+        if (onWindows_) {
+            onWindows_(pending_);
+        }
+        pending_.clear();
+    }
+
+    static int64_t floorTo(int64_t value, int64_t step) {
+        int64_t q = value / step;
+        if (value % step != 0 && value < 0) --q;
+        return q * step;
+    }
+
+    WindowSpec spec_;
+    EmitCallback onWindows_;
+    TimestampFn timestamp_;
+    bool passThrough_ = true;
+
+    RunningStats stats_;
+    MinMaxQueue window_;     // Sliding windows only
+    double min_ = 0.0;       // Tumbling and session windows
+    double max_ = 0.0;
+    int64_t windowStartNs_ = 0;
+    int64_t windowEndNs_ = 0;
+    int64_t nextEndNs_ = 0;
+    int64_t lastTimeNs_ = 0;
+    uint64_t seen_ = 0;
+    uint64_t nextWindowId_ = 0;
+    bool started_ = false;
+    std::vector<WindowResult> pending_;
+};